@@ -0,0 +1,214 @@
+#include "asset_pack.h"
+#include "asset_pack_index.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+
+// Glyph descriptors are used in place, so the layout must match the packer
+static_assert(sizeof(lv_font_fmt_txt_glyph_dsc_t) == 8,
+              "asset pack fonts need LV_FONT_FMT_TXT_LARGE 0");
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+typedef esp_partition_mmap_handle_t asset_mmap_handle_t;
+#else
+typedef spi_flash_mmap_handle_t asset_mmap_handle_t;
+#endif
+
+// Size mapped first to read the pack header (one MMU page)
+#define HEADER_MAP_SIZE 0x10000
+
+// RAM side of a flash font: LVGL descriptors pointing into the mapping
+struct pack_font_t {
+  lv_font_t font;
+  lv_font_fmt_txt_dsc_t dsc;
+  lv_font_fmt_txt_cmap_t *cmaps;
+};
+
+static asset_pack_t pack;
+static asset_mmap_handle_t map_handle;
+static bool mapped = false;
+
+// Descriptors built on first use, indexed by asset id
+static void **descriptors = nullptr;
+
+static bool map_region(const esp_partition_t *part, size_t size,
+                       const void **ptr) {
+  esp_err_t err = esp_partition_mmap(part, 0, size, ESP_PARTITION_MMAP_DATA,
+                                     ptr, &map_handle);
+  if (err != ESP_OK) {
+    Serial.printf("Asset partition mmap failed: %d\n", err);
+    return false;
+  }
+  mapped = true;
+  return true;
+}
+
+static void unmap_region() {
+  if (mapped) {
+    esp_partition_munmap(map_handle);
+    mapped = false;
+  }
+}
+
+bool asset_pack_begin() {
+  if (pack.base)
+    return true;
+
+  const esp_partition_t *part =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                               ESP_PARTITION_SUBTYPE_ANY, ASSET_PARTITION_LABEL);
+  if (!part) {
+    Serial.println("Asset partition not found");
+    return false;
+  }
+
+  // Map just the header first so only the pack (not the whole ~10 MB
+  // partition) takes up MMU pages
+  const void *ptr = nullptr;
+  size_t head_size = part->size < HEADER_MAP_SIZE ? part->size : HEADER_MAP_SIZE;
+  if (!map_region(part, head_size, &ptr))
+    return false;
+  const asset_pack_header_t *hdr = (const asset_pack_header_t *)ptr;
+  uint32_t total = hdr->total_size;
+  bool valid_magic = hdr->magic == ASSET_PACK_MAGIC;
+  unmap_region();
+
+  if (!valid_magic || total == 0 || total > part->size) {
+    Serial.println("Asset partition holds no valid pack");
+    return false;
+  }
+  if (!map_region(part, total, &ptr))
+    return false;
+
+  if (!asset_pack_parse(ptr, total, &pack)) {
+    Serial.println("Asset pack index invalid");
+    unmap_region();
+    return false;
+  }
+
+  descriptors = (void **)heap_caps_calloc(pack.count, sizeof(void *),
+                                          MALLOC_CAP_INTERNAL);
+  if (!descriptors) {
+    Serial.println("Asset descriptor table alloc failed");
+    pack.base = nullptr;
+    unmap_region();
+    return false;
+  }
+
+  Serial.printf("Asset pack mapped: %d assets, %lu bytes\n", pack.count,
+                (unsigned long)pack.size);
+  return true;
+}
+
+static pack_font_t *build_font(uint16_t id) {
+  const asset_font_header_t *hdr = asset_pack_font_header(&pack, id);
+  if (!hdr)
+    return nullptr;
+  const uint8_t *base = (const uint8_t *)hdr;
+
+  pack_font_t *pf = (pack_font_t *)heap_caps_calloc(
+      1, sizeof(pack_font_t) + hdr->cmap_num * sizeof(lv_font_fmt_txt_cmap_t),
+      MALLOC_CAP_INTERNAL);
+  if (!pf)
+    return nullptr;
+  pf->cmaps = (lv_font_fmt_txt_cmap_t *)(pf + 1);
+
+  const asset_font_cmap_t *src =
+      (const asset_font_cmap_t *)(base + hdr->cmaps_offset);
+  for (uint16_t i = 0; i < hdr->cmap_num; i++) {
+    lv_font_fmt_txt_cmap_t *cm = &pf->cmaps[i];
+    cm->range_start = src[i].range_start;
+    cm->range_length = src[i].range_length;
+    cm->glyph_id_start = src[i].glyph_id_start;
+    cm->list_length = src[i].list_length;
+    cm->type = (lv_font_fmt_txt_cmap_type_t)src[i].type;
+    cm->unicode_list =
+        src[i].unicode_list_offset
+            ? (const uint16_t *)(base + src[i].unicode_list_offset)
+            : nullptr;
+    cm->glyph_id_ofs = src[i].glyph_id_ofs_offset
+                           ? (const void *)(base + src[i].glyph_id_ofs_offset)
+                           : nullptr;
+  }
+
+  lv_font_fmt_txt_dsc_t *dsc = &pf->dsc;
+  dsc->glyph_bitmap = base + hdr->bitmap_offset;
+  dsc->glyph_dsc =
+      (const lv_font_fmt_txt_glyph_dsc_t *)(base + hdr->glyph_dsc_offset);
+  dsc->cmaps = pf->cmaps;
+  dsc->kern_dsc = nullptr;
+  dsc->kern_scale = 0;
+  dsc->cmap_num = hdr->cmap_num;
+  dsc->bpp = hdr->bpp;
+  dsc->kern_classes = 0;
+  dsc->bitmap_format = LV_FONT_FMT_TXT_PLAIN;
+
+  lv_font_t *font = &pf->font;
+  font->get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt;
+  font->get_glyph_bitmap = lv_font_get_bitmap_fmt_txt;
+  font->line_height = hdr->line_height;
+  font->base_line = hdr->base_line;
+  font->subpx = hdr->subpx;
+  font->underline_position = hdr->underline_position;
+  font->underline_thickness = hdr->underline_thickness;
+  font->dsc = dsc;
+  font->fallback = nullptr;
+  return pf;
+}
+
+static lv_image_dsc_t *build_image(uint16_t id) {
+  uint32_t size = 0;
+  const uint8_t *data =
+      (const uint8_t *)asset_pack_get(&pack, id, ASSET_TYPE_IMAGE, &size);
+  if (!data || size < sizeof(lv_image_header_t))
+    return nullptr;
+
+  lv_image_dsc_t *img = (lv_image_dsc_t *)heap_caps_calloc(
+      1, sizeof(lv_image_dsc_t), MALLOC_CAP_INTERNAL);
+  if (!img)
+    return nullptr;
+
+  memcpy(&img->header, data, sizeof(lv_image_header_t));
+  if (img->header.magic != LV_IMAGE_HEADER_MAGIC) {
+    heap_caps_free(img);
+    return nullptr;
+  }
+  img->data = data + sizeof(lv_image_header_t);
+  img->data_size = size - sizeof(lv_image_header_t);
+  return img;
+}
+
+const lv_font_t *asset_pack_font(uint16_t id) {
+  if (!descriptors || id >= pack.count ||
+      pack.index[id].type != ASSET_TYPE_FONT)
+    return nullptr;
+  if (!descriptors[id]) {
+    pack_font_t *pf = build_font(id);
+    if (!pf) {
+      Serial.printf("Asset %d is not a valid font\n", id);
+      return nullptr;
+    }
+    descriptors[id] = pf;
+  }
+  return &((pack_font_t *)descriptors[id])->font;
+}
+
+const lv_image_dsc_t *asset_pack_image(uint16_t id) {
+  if (!descriptors || id >= pack.count ||
+      pack.index[id].type != ASSET_TYPE_IMAGE)
+    return nullptr;
+  if (!descriptors[id]) {
+    lv_image_dsc_t *img = build_image(id);
+    if (!img) {
+      Serial.printf("Asset %d is not a valid image\n", id);
+      return nullptr;
+    }
+    descriptors[id] = img;
+  }
+  return (const lv_image_dsc_t *)descriptors[id];
+}
+
+const void *asset_pack_raw(uint16_t id, uint32_t *size) {
+  return asset_pack_get(&pack, id, ASSET_TYPE_RAW, size);
+}
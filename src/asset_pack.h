@@ -0,0 +1,28 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Data partition holding the asset pack (see tools/pack_assets.py)
+#define ASSET_PARTITION_LABEL "assets"
+
+/**
+ * Memory-map the asset partition and validate its index
+ * Returns false if the partition is missing or holds no valid pack
+ */
+bool asset_pack_begin();
+
+/**
+ * Font served in place from flash; only small descriptors live in RAM
+ * Returns nullptr if the id is not a font (use a built-in font as fallback)
+ */
+const lv_font_t *asset_pack_font(uint16_t id);
+
+/**
+ * Image descriptor whose pixel data points straight into flash
+ */
+const lv_image_dsc_t *asset_pack_image(uint16_t id);
+
+/**
+ * Raw asset bytes in flash
+ */
+const void *asset_pack_raw(uint16_t id, uint32_t *size);
@@ -0,0 +1,115 @@
+#include "asset_pack_index.h"
+
+// True if [offset, offset + len) lies within a region of the given size.
+// len is 64-bit so count * entry size can't wrap before the check.
+static bool in_range(uint32_t offset, uint64_t len, uint32_t size) {
+  return offset <= size && len <= size - offset;
+}
+
+bool asset_pack_parse(const void *base, size_t size, asset_pack_t *pack) {
+  if (!base || !pack || size < sizeof(asset_pack_header_t))
+    return false;
+  if (((uintptr_t)base & 3) != 0)
+    return false;
+
+  const uint8_t *bytes = (const uint8_t *)base;
+  const asset_pack_header_t *hdr = (const asset_pack_header_t *)bytes;
+  if (hdr->magic != ASSET_PACK_MAGIC || hdr->version != ASSET_PACK_VERSION)
+    return false;
+  if (hdr->total_size > size || hdr->total_size < sizeof(*hdr))
+    return false;
+  if ((hdr->index_offset & 3) != 0 ||
+      !in_range(hdr->index_offset,
+                (uint64_t)hdr->count * sizeof(asset_index_entry_t),
+                hdr->total_size))
+    return false;
+
+  const asset_index_entry_t *index =
+      (const asset_index_entry_t *)(bytes + hdr->index_offset);
+  for (uint16_t i = 0; i < hdr->count; i++) {
+    if ((index[i].offset & 3) != 0 ||
+        !in_range(index[i].offset, index[i].size, hdr->total_size))
+      return false;
+  }
+
+  pack->base = bytes;
+  pack->size = hdr->total_size;
+  pack->index = index;
+  pack->count = hdr->count;
+  return true;
+}
+
+const void *asset_pack_get(const asset_pack_t *pack, uint16_t id,
+                           uint16_t type, uint32_t *size) {
+  if (!pack || !pack->base || id >= pack->count)
+    return nullptr;
+  const asset_index_entry_t *e = &pack->index[id];
+  if (e->type != type)
+    return nullptr;
+  if (size)
+    *size = e->size;
+  return pack->base + e->offset;
+}
+
+const asset_font_header_t *asset_pack_font_header(const asset_pack_t *pack,
+                                                  uint16_t id) {
+  uint32_t size = 0;
+  const uint8_t *font =
+      (const uint8_t *)asset_pack_get(pack, id, ASSET_TYPE_FONT, &size);
+  if (!font || size < sizeof(asset_font_header_t))
+    return nullptr;
+
+  const asset_font_header_t *hdr = (const asset_font_header_t *)font;
+  if (hdr->magic != ASSET_FONT_MAGIC)
+    return nullptr;
+  if (hdr->bpp != 1 && hdr->bpp != 2 && hdr->bpp != 4 && hdr->bpp != 8)
+    return nullptr;
+  if ((hdr->cmaps_offset & 3) != 0 || (hdr->glyph_dsc_offset & 3) != 0)
+    return nullptr;
+  if (!in_range(hdr->cmaps_offset,
+                (uint64_t)hdr->cmap_num * sizeof(asset_font_cmap_t), size) ||
+      !in_range(hdr->glyph_dsc_offset,
+                (uint64_t)hdr->glyph_count * sizeof(asset_font_glyph_t),
+                size) ||
+      !in_range(hdr->bitmap_offset, hdr->bitmap_size, size))
+    return nullptr;
+
+  const asset_font_glyph_t *glyphs =
+      (const asset_font_glyph_t *)(font + hdr->glyph_dsc_offset);
+  for (uint32_t i = 0; i < hdr->glyph_count; i++) {
+    const asset_font_glyph_t *g = &glyphs[i];
+    // Bitmaps start on a byte boundary (see convert_font in the packer)
+    uint32_t bytes = ((uint32_t)g->box_w * g->box_h * hdr->bpp + 7) / 8;
+    if (!in_range(g->bitmap_index_adv & 0xFFFFF, bytes, hdr->bitmap_size))
+      return nullptr;
+  }
+
+  const asset_font_cmap_t *cmaps =
+      (const asset_font_cmap_t *)(font + hdr->cmaps_offset);
+  for (uint16_t i = 0; i < hdr->cmap_num; i++) {
+    const asset_font_cmap_t *c = &cmaps[i];
+    if (c->type > 3)
+      return nullptr;
+    // unicode_list is uint16_t; glyph_id_ofs is uint8_t (full) or uint16_t
+    if (c->unicode_list_offset &&
+        ((c->unicode_list_offset & 1) ||
+         !in_range(c->unicode_list_offset, c->list_length * 2u, size)))
+      return nullptr;
+    uint32_t ofs_width = (c->type == 0) ? 1 : 2;
+    uint32_t ofs_count = (c->type == 0) ? c->range_length : c->list_length;
+    if (c->glyph_id_ofs_offset &&
+        ((c->glyph_id_ofs_offset & (ofs_width - 1)) ||
+         !in_range(c->glyph_id_ofs_offset, ofs_count * ofs_width, size)))
+      return nullptr;
+  }
+  return hdr;
+}
+
+uint32_t asset_name_hash(const char *name) {
+  uint32_t h = 2166136261u;
+  for (; name && *name; name++) {
+    h ^= (uint8_t)*name;
+    h *= 16777619u;
+  }
+  return h;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// Asset pack format shared by tools/pack_assets.py and the runtime loader.
+// Plain C++ with no Arduino/LVGL dependencies so it also builds on a host.
+//
+// Layout (little-endian, every section 4-byte aligned):
+//   asset_pack_header_t
+//   asset_index_entry_t[count]   indexed directly by asset id
+//   asset data...
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_PACK_MAGIC 0x4B415041 // "APAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_FONT_MAGIC 0x544E4646 // "FFNT"
+
+enum asset_type_t : uint16_t {
+  ASSET_TYPE_RAW = 0,
+  ASSET_TYPE_FONT = 1,  // Flat font (asset_font_header_t)
+  ASSET_TYPE_IMAGE = 2, // LVGL 9 image binary (lv_image_header_t + pixels)
+};
+
+struct asset_pack_header_t {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  uint32_t index_offset;
+  uint32_t total_size;
+};
+
+struct asset_index_entry_t {
+  uint32_t offset; // From start of pack
+  uint32_t size;
+  uint16_t type;
+  uint16_t flags;
+  uint32_t name_hash; // FNV-1a of the asset name, for sanity checks
+};
+
+// Flat font: LVGL fmt_txt tables laid out so they can be used in place
+struct asset_font_header_t {
+  uint32_t magic;
+  int16_t line_height;
+  int16_t base_line;
+  int16_t underline_position;
+  uint16_t underline_thickness;
+  uint8_t bpp;
+  uint8_t subpx;
+  uint16_t cmap_num;
+  uint32_t glyph_count;
+  uint32_t cmaps_offset;     // From start of font asset
+  uint32_t glyph_dsc_offset; // asset_font_glyph_t[glyph_count]
+  uint32_t bitmap_offset;
+  uint32_t bitmap_size;
+};
+
+// Same bit layout as lv_font_fmt_txt_glyph_dsc_t
+struct asset_font_glyph_t {
+  uint32_t bitmap_index_adv; // bitmap_index: low 20 bits, adv_w: high 12
+  uint8_t box_w;
+  uint8_t box_h;
+  int8_t ofs_x;
+  int8_t ofs_y;
+};
+
+struct asset_font_cmap_t {
+  uint32_t range_start;
+  uint16_t range_length;
+  uint16_t glyph_id_start;
+  uint16_t list_length;
+  uint8_t type; // lv_font_fmt_txt_cmap_type_t
+  uint8_t reserved;
+  uint32_t unicode_list_offset; // From start of font asset, 0 = none
+  uint32_t glyph_id_ofs_offset; // From start of font asset, 0 = none
+};
+
+static_assert(sizeof(asset_pack_header_t) == 16, "pack header layout");
+static_assert(sizeof(asset_index_entry_t) == 16, "index entry layout");
+static_assert(sizeof(asset_font_header_t) == 36, "font header layout");
+static_assert(sizeof(asset_font_glyph_t) == 8, "font glyph layout");
+static_assert(sizeof(asset_font_cmap_t) == 20, "font cmap layout");
+
+struct asset_pack_t {
+  const uint8_t *base;
+  uint32_t size;
+  const asset_index_entry_t *index;
+  uint16_t count;
+};
+
+/**
+ * Validate a pack image and fill in the lookup handle
+ * Checks the header, the index and that every entry lies inside the pack
+ */
+bool asset_pack_parse(const void *base, size_t size, asset_pack_t *pack);
+
+/**
+ * O(1) lookup of an asset by id, optionally checking its type
+ * Returns a pointer to the asset data or nullptr
+ */
+const void *asset_pack_get(const asset_pack_t *pack, uint16_t id,
+                           uint16_t type, uint32_t *size);
+
+/**
+ * Look up a flat font and validate all of its table offsets and that
+ * every glyph bitmap lies inside the bitmap table
+ */
+const asset_font_header_t *asset_pack_font_header(const asset_pack_t *pack,
+                                                  uint16_t id);
+
+/**
+ * FNV-1a hash used for asset names (matches the packer)
+ */
+uint32_t asset_name_hash(const char *name);
@@ -0,0 +1,282 @@
+#include "battery_governor.h"
+#include "perf_governor.h"
+#include "serial_console.h"
+#include <Arduino.h>
+#include <esp_idf_version.h>
+#include <string.h>
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_adc/adc_continuous.h>
+// Full 0..3.1 V input range (DB_11 is the deprecated name)
+#define ADC_ATTEN ADC_ATTEN_DB_12
+#else
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#define ADC_ATTEN ADC_ATTEN_DB_11
+#endif
+
+// DMA frame: 4-byte results, so 64 samples per frame
+#define ADC_FRAME_BYTES (64 * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_STORE_BYTES (2 * ADC_FRAME_BYTES)
+#define ADC_MAX_SAMPLES (ADC_STORE_BYTES / SOC_ADC_DIGI_RESULT_BYTES)
+
+// Longest wait for a burst's first frame (one frame takes ~3 ms)
+#define ADC_FRAME_TIMEOUT_MS 10
+
+static bool adc_ok = false;
+static uint8_t adc_channel = 0;
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+static adc_continuous_handle_t adc_handle = nullptr;
+static adc_cali_handle_t cali = nullptr;
+#else
+static esp_adc_cal_characteristics_t cali;
+#endif
+
+static uint8_t dma_buf[ADC_STORE_BYTES];
+static uint16_t block[ADC_MAX_SAMPLES];
+
+static battery_filter_t filter;
+static battery_energy_t energy;
+static battery_level_t level = BATTERY_EXTERNAL; // No limits until measured
+static uint32_t filtered_mv = 0;
+static uint32_t last_block_mv = 0;
+static uint8_t last_brightness = 0;
+static battery_state_t last_state = BATTERY_STATE_ACTIVE;
+static uint32_t last_sample_ms = 0;
+static uint32_t last_account_ms = 0;
+static bool trace = false;
+
+static bool adc_setup() {
+  adc_channel = digitalPinToAnalogChannel(BATTERY_ADC_PIN);
+
+  adc_digi_pattern_config_t pattern = {};
+  pattern.atten = ADC_ATTEN;
+  pattern.channel = adc_channel;
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+  adc_continuous_handle_cfg_t handle_cfg = {};
+  handle_cfg.max_store_buf_size = ADC_STORE_BYTES;
+  handle_cfg.conv_frame_size = ADC_FRAME_BYTES;
+  if (adc_continuous_new_handle(&handle_cfg, &adc_handle) != ESP_OK)
+    return false;
+
+  pattern.unit = ADC_UNIT_1;
+  adc_continuous_config_t cfg = {};
+  cfg.pattern_num = 1;
+  cfg.adc_pattern = &pattern;
+  cfg.sample_freq_hz = BATTERY_ADC_HZ;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_continuous_config(adc_handle, &cfg) != ESP_OK)
+    return false;
+
+  adc_cali_curve_fitting_config_t cali_cfg = {};
+  cali_cfg.unit_id = ADC_UNIT_1;
+  cali_cfg.atten = ADC_ATTEN;
+  cali_cfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+  if (adc_cali_create_scheme_curve_fitting(&cali_cfg, &cali) != ESP_OK)
+    return false;
+#else
+  adc_digi_init_config_t init_cfg = {};
+  init_cfg.max_store_buf_size = ADC_STORE_BYTES;
+  init_cfg.conv_num_each_intr = ADC_FRAME_BYTES;
+  init_cfg.adc1_chan_mask = BIT(adc_channel);
+  if (adc_digi_initialize(&init_cfg) != ESP_OK)
+    return false;
+
+  pattern.unit = 0; // ADC1
+  adc_digi_configuration_t cfg = {};
+  cfg.conv_limit_en = false;
+  cfg.pattern_num = 1;
+  cfg.adc_pattern = &pattern;
+  cfg.sample_freq_hz = BATTERY_ADC_HZ;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_digi_controller_configure(&cfg) != ESP_OK)
+    return false;
+
+  esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN, ADC_WIDTH_BIT_12, 1100,
+                           &cali);
+#endif
+  return true;
+}
+
+// The converter only runs for a burst: while it runs, its DMA interrupts and
+// the driver's APB lock keep the CPU from scaling down
+static bool adc_run(bool run) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_err_t err = run ? adc_continuous_start(adc_handle)
+                      : adc_continuous_stop(adc_handle);
+#else
+  esp_err_t err = run ? adc_digi_start() : adc_digi_stop();
+#endif
+  return err == ESP_OK;
+}
+
+static uint32_t adc_read(uint8_t *buf, uint32_t len, uint32_t timeout_ms) {
+  uint32_t got = 0;
+#if ESP_IDF_VERSION_MAJOR >= 5
+  if (adc_continuous_read(adc_handle, buf, len, &got, timeout_ms) != ESP_OK)
+    return 0;
+#else
+  if (adc_digi_read_bytes(buf, len, &got, timeout_ms) != ESP_OK)
+    return 0;
+#endif
+  return got;
+}
+
+static uint32_t raw_to_mv(uint32_t raw) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  int mv = 0;
+  adc_cali_raw_to_voltage(cali, raw, &mv);
+  return (uint32_t)mv * BATTERY_DIVIDER;
+#else
+  return esp_adc_cal_raw_to_voltage(raw, &cali) * BATTERY_DIVIDER;
+#endif
+}
+
+// Convert `got` bytes of results in dma_buf into block[]
+static void add_results(uint32_t got, size_t *count) {
+  for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got;
+       i += SOC_ADC_DIGI_RESULT_BYTES) {
+    const adc_digi_output_data_t *d =
+        (const adc_digi_output_data_t *)&dma_buf[i];
+    if (d->type2.channel == adc_channel)
+      block[(*count)++ % ADC_MAX_SAMPLES] = (uint16_t)raw_to_mv(d->type2.data);
+  }
+}
+
+// One burst: start the converter, wait for a frame, stop it and take what
+// else it finished meanwhile, reduced to one block mean (0 if none)
+static uint32_t read_block() {
+  if (!adc_run(true))
+    return 0;
+  size_t count = 0;
+  uint32_t got = adc_read(dma_buf, ADC_FRAME_BYTES, ADC_FRAME_TIMEOUT_MS);
+  adc_run(false);
+  add_results(got, &count);
+  while ((got = adc_read(dma_buf, sizeof(dma_buf), 0)) > 0)
+    add_results(got, &count);
+  return battery_block_mv(block, count < ADC_MAX_SAMPLES ? count
+                                                         : ADC_MAX_SAMPLES);
+}
+
+static void apply_level(battery_level_t next) {
+  const battery_limits_t *lim = battery_limits(next);
+  Serial.printf("Battery: %s -> %s at %lu mV (%u%%), brightness cap %u, "
+                "refresh >= %lu ms, sleep poll %lu ms\n",
+                battery_level_name(level), battery_level_name(next),
+                (unsigned long)filtered_mv, battery_soc_pct(filtered_mv),
+                lim->brightness_cap, (unsigned long)lim->refr_floor_ms,
+                (unsigned long)lim->sleep_poll_ms);
+  level = next;
+  perf_governor_set_refresh_floor(lim->refr_floor_ms);
+}
+
+static void account(battery_state_t state, uint32_t now) {
+  battery_load_t load = {state, last_brightness,
+                         battery_limits(level)->sleep_poll_ms};
+  battery_energy_account(&energy, &load, now - last_account_ms);
+  last_account_ms = now;
+}
+
+bool battery_governor_service(battery_state_t state, uint8_t brightness) {
+  uint32_t now = millis();
+  account(last_state, now);
+  last_state = state;
+  last_brightness = brightness;
+
+  if (!adc_ok || now - last_sample_ms < BATTERY_SAMPLE_MS)
+    return false;
+  last_sample_ms = now;
+
+  uint32_t mv = read_block();
+  if (mv == 0)
+    return false;
+  last_block_mv = mv;
+  filtered_mv = (uint32_t)(battery_filter_step(&filter, mv, now) + 0.5f);
+
+  if (trace) {
+    Serial.printf("BATTERY_TRACE ms=%lu block_mv=%lu mv=%lu soc=%u "
+                  "level=%s avg_ma=%.1f\n",
+                  (unsigned long)now, (unsigned long)mv,
+                  (unsigned long)filtered_mv, battery_soc_pct(filtered_mv),
+                  battery_level_name(level), battery_energy_avg_ma(&energy));
+  }
+
+  battery_level_t next = battery_level_step(level, filtered_mv);
+  if (next == level)
+    return false;
+  apply_level(next);
+  return true;
+}
+
+void battery_governor_sleep(bool sleeping) {
+  uint32_t now = millis();
+  if (sleeping) {
+    account(last_state, now);
+    return;
+  }
+
+  // The whole stretch since sleep began was light sleep with polling
+  account(BATTERY_STATE_SLEEP, now);
+}
+
+const battery_limits_t *battery_governor_limits() {
+  return battery_limits(level);
+}
+
+void battery_governor_report() {
+  uint8_t soc = battery_soc_pct(filtered_mv);
+  float avg = battery_energy_avg_ma(&energy);
+  float total = energy.time_ms > 0.0f ? energy.time_ms : 1.0f;
+  Serial.printf("Battery: %lu mV (block %lu mV), %u%%, %s; model %.1f mA "
+                "(active %u%%, quiet %u%%, sleep %u%%), ~%lu min left\n",
+                (unsigned long)filtered_mv, (unsigned long)last_block_mv, soc,
+                battery_level_name(level), avg,
+                (unsigned)(100 * energy.state_ms[BATTERY_STATE_ACTIVE] / total),
+                (unsigned)(100 * energy.state_ms[BATTERY_STATE_QUIET] / total),
+                (unsigned)(100 * energy.state_ms[BATTERY_STATE_SLEEP] / total),
+                (unsigned long)battery_runtime_min(soc, avg));
+
+  // What the charge would last in each state alone
+  static const char *const names[BATTERY_STATE_COUNT] = {"active", "quiet",
+                                                         "sleep"};
+  for (int s = 0; s < BATTERY_STATE_COUNT; s++) {
+    battery_load_t load = {(battery_state_t)s, last_brightness,
+                           battery_limits(level)->sleep_poll_ms};
+    float ma = battery_load_ma(&load);
+    Serial.printf("  %-6s %5.1f mA -> %lu min\n", names[s], ma,
+                  (unsigned long)battery_runtime_min(soc, ma));
+  }
+}
+
+static void battery_command(const char *args) {
+  if (strcmp(args, "trace on") == 0) {
+    trace = true;
+  } else if (strcmp(args, "trace off") == 0) {
+    trace = false;
+  } else if (*args == '\0') {
+    battery_governor_report();
+  } else {
+    Serial.println("usage: battery [trace on|off]");
+  }
+}
+
+void battery_governor_begin() {
+  battery_filter_init(&filter);
+  battery_energy_init(&energy);
+  last_account_ms = last_sample_ms = millis();
+
+  adc_ok = adc_setup();
+  if (!adc_ok) {
+    Serial.println("Battery: ADC setup failed, no battery limits");
+  } else {
+    Serial.printf("Battery: sampling GPIO%d every %d ms (%d Hz DMA bursts)\n",
+                  BATTERY_ADC_PIN, BATTERY_SAMPLE_MS, BATTERY_ADC_HZ);
+  }
+  serial_console_register("battery", battery_command);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "battery_model.h"
+#include <stdint.h>
+
+// Battery voltage monitor (through a 1:2 divider)
+#define BATTERY_ADC_PIN 1
+#define BATTERY_DIVIDER 2
+
+// Every BATTERY_SAMPLE_MS the ADC's DMA mode runs for one 64-sample frame
+// at BATTERY_ADC_HZ (~3 ms), then stops; the frame is averaged and fed to
+// the filter
+#define BATTERY_ADC_HZ 20000
+#define BATTERY_SAMPLE_MS 1000
+
+/**
+ * Set up ADC sampling on GPIO1 and register the "battery" console command
+ * ("battery [trace on|off]")
+ */
+void battery_governor_begin();
+
+/**
+ * Account this pass's load and, once per BATTERY_SAMPLE_MS, sample a burst
+ * and update the filtered voltage and level (call every loop pass).
+ * Returns true when the level, and with it the limits, changed.
+ */
+bool battery_governor_service(battery_state_t state, uint8_t brightness);
+
+/**
+ * Bracket light sleep: the time is accounted as sleep
+ */
+void battery_governor_sleep(bool sleeping);
+
+/**
+ * Limits for the current charge level
+ */
+const battery_limits_t *battery_governor_limits();
+
+/**
+ * Print voltage, charge, level, modelled current and runtime estimates
+ */
+void battery_governor_report();
@@ -0,0 +1,167 @@
+#include "battery_model.h"
+#include <algorithm>
+#include <math.h>
+
+// Resting voltage -> charge for a typical 1S LiPo, highest first
+static const struct {
+  uint16_t mv;
+  uint8_t pct;
+} ocv_table[] = {
+    {4200, 100}, {4100, 90}, {4000, 78}, {3900, 64}, {3800, 48},
+    {3750, 38},  {3700, 26}, {3650, 15}, {3600, 8},  {3500, 3},
+    {3300, 0},
+};
+
+#define OCV_POINTS (sizeof(ocv_table) / sizeof(ocv_table[0]))
+
+static const battery_limits_t limits[BATTERY_LEVEL_COUNT] = {
+    {255, UINT32_MAX, 0, 100}, // BATTERY_EXTERNAL
+    {255, UINT32_MAX, 0, 100}, // BATTERY_NORMAL
+    {120, 5000, 33, 200},      // BATTERY_LOW
+    {50, 3000, 50, 400},       // BATTERY_CRITICAL
+};
+
+uint32_t battery_block_mv(uint16_t *mv, size_t count) {
+  if (count == 0)
+    return 0;
+  std::sort(mv, mv + count);
+  size_t lo = count / 4;
+  size_t hi = count - count / 4;
+  uint32_t sum = 0;
+  for (size_t i = lo; i < hi; i++)
+    sum += mv[i];
+  return sum / (hi - lo);
+}
+
+void battery_filter_init(battery_filter_t *f) {
+  f->mv = 0.0f;
+  f->last_ms = 0;
+  f->primed = false;
+}
+
+float battery_filter_step(battery_filter_t *f, uint32_t block_mv,
+                          uint32_t now_ms) {
+  float x = (float)block_mv;
+  if (!f->primed || fabsf(x - f->mv) > BATTERY_FILTER_RESET_MV) {
+    f->mv = x;
+    f->primed = true;
+  } else {
+    // First-order low-pass that stays correct for uneven sample spacing
+    float dt = (float)(now_ms - f->last_ms);
+    float alpha = dt / (BATTERY_FILTER_TAU_MS + dt);
+    f->mv += alpha * (x - f->mv);
+  }
+  f->last_ms = now_ms;
+  return f->mv;
+}
+
+uint8_t battery_soc_pct(uint32_t mv) {
+  if (mv >= ocv_table[0].mv)
+    return 100;
+  for (size_t i = 1; i < OCV_POINTS; i++) {
+    if (mv >= ocv_table[i].mv) {
+      // Linear between the two surrounding points
+      uint32_t span_mv = ocv_table[i - 1].mv - ocv_table[i].mv;
+      uint32_t span_pct = ocv_table[i - 1].pct - ocv_table[i].pct;
+      return ocv_table[i].pct +
+             (mv - ocv_table[i].mv) * span_pct / span_mv;
+    }
+  }
+  return 0;
+}
+
+battery_level_t battery_level_step(battery_level_t level, uint32_t mv) {
+  if (mv >= BATTERY_EXTERNAL_MV)
+    return BATTERY_EXTERNAL;
+
+  uint8_t soc = battery_soc_pct(mv);
+  if (level == BATTERY_EXTERNAL)
+    level = BATTERY_NORMAL; // Re-evaluate from scratch below
+
+  // Drop as soon as a threshold is crossed, recover only past hysteresis
+  switch (level) {
+  case BATTERY_NORMAL:
+    if (soc < BATTERY_CRITICAL_PCT)
+      return BATTERY_CRITICAL;
+    if (soc < BATTERY_LOW_PCT)
+      return BATTERY_LOW;
+    return BATTERY_NORMAL;
+  case BATTERY_LOW:
+    if (soc < BATTERY_CRITICAL_PCT)
+      return BATTERY_CRITICAL;
+    if (soc >= BATTERY_LOW_PCT + BATTERY_HYSTERESIS_PCT)
+      return BATTERY_NORMAL;
+    return BATTERY_LOW;
+  case BATTERY_CRITICAL:
+  default:
+    if (soc >= BATTERY_LOW_PCT + BATTERY_HYSTERESIS_PCT)
+      return BATTERY_NORMAL;
+    if (soc >= BATTERY_CRITICAL_PCT + BATTERY_HYSTERESIS_PCT)
+      return BATTERY_LOW;
+    return BATTERY_CRITICAL;
+  }
+}
+
+const battery_limits_t *battery_limits(battery_level_t level) {
+  return &limits[level < BATTERY_LEVEL_COUNT ? level : BATTERY_NORMAL];
+}
+
+const char *battery_level_name(battery_level_t level) {
+  switch (level) {
+  case BATTERY_EXTERNAL:
+    return "external";
+  case BATTERY_NORMAL:
+    return "normal";
+  case BATTERY_LOW:
+    return "low";
+  case BATTERY_CRITICAL:
+    return "critical";
+  default:
+    return "?";
+  }
+}
+
+float battery_load_ma(const battery_load_t *load) {
+  switch (load->state) {
+  case BATTERY_STATE_ACTIVE:
+    return BATTERY_ACTIVE_MA + BATTERY_DISPLAY_MA * load->brightness / 255.0f;
+  case BATTERY_STATE_QUIET:
+    return BATTERY_QUIET_MA + BATTERY_DISPLAY_MA * load->brightness / 255.0f;
+  case BATTERY_STATE_SLEEP:
+  default: {
+    // Each poll wake (I2C read of the trackball) costs a fixed charge
+    uint32_t poll_ms = load->sleep_poll_ms ? load->sleep_poll_ms : 1;
+    return BATTERY_SLEEP_MA + BATTERY_POLL_MAS * 1000.0f / poll_ms;
+  }
+  }
+}
+
+void battery_energy_init(battery_energy_t *e) {
+  e->charge_mams = 0.0f;
+  e->time_ms = 0.0f;
+  for (int i = 0; i < BATTERY_STATE_COUNT; i++)
+    e->state_ms[i] = 0.0f;
+}
+
+void battery_energy_account(battery_energy_t *e, const battery_load_t *load,
+                            uint32_t dt_ms) {
+  if (dt_ms == 0)
+    return;
+  float decay = expf(-(float)dt_ms / BATTERY_ENERGY_WINDOW_MS);
+  e->charge_mams = e->charge_mams * decay + battery_load_ma(load) * dt_ms;
+  e->time_ms = e->time_ms * decay + dt_ms;
+  for (int i = 0; i < BATTERY_STATE_COUNT; i++)
+    e->state_ms[i] *= decay;
+  e->state_ms[load->state] += dt_ms;
+}
+
+float battery_energy_avg_ma(const battery_energy_t *e) {
+  return e->time_ms > 0.0f ? e->charge_mams / e->time_ms : 0.0f;
+}
+
+uint32_t battery_runtime_min(uint8_t soc_pct, float avg_ma) {
+  if (avg_ma <= 0.0f)
+    return UINT32_MAX;
+  float mah = BATTERY_CAPACITY_MAH * soc_pct / 100.0f;
+  return (uint32_t)(mah / avg_ma * 60.0f);
+}
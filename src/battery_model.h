@@ -0,0 +1,125 @@
+#pragma once
+
+// Voltage filtering, charge level and runtime model for battery_governor.cpp.
+// Plain C++ with no Arduino dependencies so recorded voltage traces can be
+// replayed through it on a host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Low-pass time constant for the cell voltage (load steps settle in ~1 min)
+#define BATTERY_FILTER_TAU_MS 20000
+// A jump this large (USB plugged/unplugged) restarts the filter
+#define BATTERY_FILTER_RESET_MV 300
+
+// Above this the board runs from USB (charging or no cell fitted)
+#define BATTERY_EXTERNAL_MV 4350
+
+// Charge thresholds; leaving a level needs BATTERY_HYSTERESIS_PCT extra
+#define BATTERY_LOW_PCT 20
+#define BATTERY_CRITICAL_PCT 8
+#define BATTERY_HYSTERESIS_PCT 3
+
+// Energy model (defaults for the fitted cell, tune from a discharge log)
+#define BATTERY_CAPACITY_MAH 500
+#define BATTERY_ACTIVE_MA 75.0f  // 240 MHz, refreshing, panel dark
+#define BATTERY_QUIET_MA 40.0f   // Quiet profile, panel dark
+#define BATTERY_DISPLAY_MA 45.0f // Extra at panel value 255
+#define BATTERY_SLEEP_MA 2.5f    // Light sleep with the panel asleep
+#define BATTERY_POLL_MAS 0.08f   // Charge per sleep-poll wake (mA*s)
+// Older load history fades out over this window
+#define BATTERY_ENERGY_WINDOW_MS (10 * 60 * 1000UL)
+
+enum battery_level_t {
+  BATTERY_EXTERNAL, // USB powered, no limits
+  BATTERY_NORMAL,
+  BATTERY_LOW,
+  BATTERY_CRITICAL,
+  BATTERY_LEVEL_COUNT
+};
+
+// What the governor limits at each level
+struct battery_limits_t {
+  uint8_t brightness_cap;   // Panel value
+  uint32_t idle_timeout_ms; // Longest idle timeout allowed
+  uint32_t refr_floor_ms;   // Shortest LVGL refresh period allowed
+  uint32_t sleep_poll_ms;   // Light-sleep trackball polling interval
+};
+
+struct battery_filter_t {
+  float mv;
+  uint32_t last_ms;
+  bool primed;
+};
+
+enum battery_state_t {
+  BATTERY_STATE_ACTIVE, // Awake, performance profile
+  BATTERY_STATE_QUIET,  // Awake, quiet profile
+  BATTERY_STATE_SLEEP,  // Light sleep
+  BATTERY_STATE_COUNT
+};
+
+// Load during one accounted interval
+struct battery_load_t {
+  battery_state_t state;
+  uint8_t brightness;     // Panel value (ignored while asleep)
+  uint32_t sleep_poll_ms; // Only used while asleep
+};
+
+struct battery_energy_t {
+  float charge_mams; // Decayed charge drawn (mA*ms)
+  float time_ms;     // Decayed time accounted
+  float state_ms[BATTERY_STATE_COUNT];
+};
+
+/**
+ * Robust mean of one block of readings: the middle half after sorting, so
+ * spikes from radio/flash/SPI bursts don't move it. `mv` is reordered.
+ */
+uint32_t battery_block_mv(uint16_t *mv, size_t count);
+
+void battery_filter_init(battery_filter_t *f);
+
+/**
+ * Feed a block mean taken at now_ms; returns the filtered voltage
+ */
+float battery_filter_step(battery_filter_t *f, uint32_t block_mv,
+                          uint32_t now_ms);
+
+/**
+ * State of charge from the resting voltage of a 1S LiPo (0..100)
+ */
+uint8_t battery_soc_pct(uint32_t mv);
+
+/**
+ * Next level for the filtered voltage and its charge, with hysteresis
+ */
+battery_level_t battery_level_step(battery_level_t level, uint32_t mv);
+
+const battery_limits_t *battery_limits(battery_level_t level);
+
+const char *battery_level_name(battery_level_t level);
+
+/**
+ * Modelled supply current for a load
+ */
+float battery_load_ma(const battery_load_t *load);
+
+void battery_energy_init(battery_energy_t *e);
+
+/**
+ * Account dt_ms spent under `load`; history older than
+ * BATTERY_ENERGY_WINDOW_MS fades out
+ */
+void battery_energy_account(battery_energy_t *e, const battery_load_t *load,
+                            uint32_t dt_ms);
+
+/**
+ * Average current over the recent mix of states (0 before any accounting)
+ */
+float battery_energy_avg_ma(const battery_energy_t *e);
+
+/**
+ * Minutes left at soc_pct drawing avg_ma (UINT32_MAX if avg_ma is 0)
+ */
+uint32_t battery_runtime_min(uint8_t soc_pct, float avg_ma);
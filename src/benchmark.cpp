@@ -0,0 +1,286 @@
+#include "benchmark.h"
+#include "qspi_display.h"
+#include "render_config.h"
+#include "screen_manager.h"
+#include "serial_console.h"
+#include "settings.h"
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define NVS_NAMESPACE "bench"
+
+// Text scenes
+#define BENCH_LABEL_LINES 40
+#define BENCH_SCROLL_STEP 4
+
+// Alpha scene
+#define BENCH_OVERLAYS 3
+#define BENCH_OVERLAY_W 220
+#define BENCH_OVERLAY_H 160
+
+struct bench_scene_t {
+  const char *name;
+  // Build the scene; returns a screen to load and delete afterwards, or
+  // NULL when an existing page was shown instead
+  lv_obj_t *(*setup)();
+  void (*step)(uint32_t frame);
+};
+
+// Flush accounting (only while a scene is measured)
+static bool measuring = false;
+static uint32_t flush_us = 0;
+static uint32_t flush_count = 0;
+static uint64_t flush_bytes = 0;
+
+// Objects the current scene animates
+static lv_obj_t *scene_obj = nullptr;
+static lv_obj_t *overlays[BENCH_OVERLAYS];
+static int scroll_dir = 1;
+
+void benchmark_count_flush(uint32_t bytes, uint32_t push_us) {
+  if (!measuring)
+    return;
+  flush_us += push_us;
+  flush_count++;
+  flush_bytes += bytes;
+}
+
+static lv_obj_t *new_screen() {
+  lv_obj_t *scr = lv_obj_create(NULL);
+  lv_obj_remove_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
+  lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+  return scr;
+}
+
+static lv_color_t hue(uint32_t degrees) {
+  return lv_color_hsv_to_rgb(degrees % 360, 100, 100);
+}
+
+// Full-screen solid fill, new colour every frame
+static lv_obj_t *fill_setup() {
+  scene_obj = new_screen();
+  return scene_obj;
+}
+
+static void fill_step(uint32_t frame) {
+  lv_obj_set_style_bg_color(scene_obj, hue(frame * 37), 0);
+}
+
+// Full-screen two-colour gradient, alternating direction
+static lv_obj_t *gradient_setup() {
+  scene_obj = new_screen();
+  return scene_obj;
+}
+
+static void gradient_step(uint32_t frame) {
+  lv_obj_set_style_bg_color(scene_obj, hue(frame * 11), 0);
+  lv_obj_set_style_bg_grad_color(scene_obj, hue(frame * 11 + 180), 0);
+  lv_obj_set_style_bg_grad_dir(
+      scene_obj, (frame & 1) ? LV_GRAD_DIR_HOR : LV_GRAD_DIR_VER, 0);
+}
+
+// Half-transparent rounded panels sliding over a gradient
+static lv_obj_t *alpha_setup() {
+  lv_obj_t *scr = new_screen();
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x203060), 0);
+  lv_obj_set_style_bg_grad_color(scr, lv_color_hex(0x602030), 0);
+  lv_obj_set_style_bg_grad_dir(scr, LV_GRAD_DIR_HOR, 0);
+
+  static const uint32_t colors[BENCH_OVERLAYS] = {0xff4040, 0x40ff40,
+                                                  0x4040ff};
+  for (int i = 0; i < BENCH_OVERLAYS; i++) {
+    lv_obj_t *o = lv_obj_create(scr);
+    lv_obj_remove_style_all(o);
+    lv_obj_set_size(o, BENCH_OVERLAY_W, BENCH_OVERLAY_H);
+    lv_obj_set_style_radius(o, 16, 0);
+    lv_obj_set_style_bg_opa(o, LV_OPA_50, 0);
+    lv_obj_set_style_bg_color(o, lv_color_hex(colors[i]), 0);
+    overlays[i] = o;
+  }
+  return scr;
+}
+
+static void alpha_step(uint32_t frame) {
+  const int32_t span_x = LCD_WIDTH + BENCH_OVERLAY_W;
+  for (int i = 0; i < BENCH_OVERLAYS; i++) {
+    int32_t x = (int32_t)((frame * 8 + i * span_x / BENCH_OVERLAYS) % span_x) -
+                BENCH_OVERLAY_W;
+    int32_t y = i * (LCD_HEIGHT - BENCH_OVERLAY_H) / (BENCH_OVERLAYS - 1);
+    lv_obj_set_pos(overlays[i], x, y);
+  }
+}
+
+// A scrolling column of text in the given font
+static lv_obj_t *labels_setup(const lv_font_t *font) {
+  lv_obj_t *scr = new_screen();
+  lv_obj_t *cont = lv_obj_create(scr);
+  lv_obj_remove_style_all(cont);
+  lv_obj_set_size(cont, LCD_WIDTH, LCD_HEIGHT);
+  lv_obj_set_flex_flow(cont, LV_FLEX_FLOW_COLUMN);
+  lv_obj_set_style_pad_all(cont, 8, 0);
+  lv_obj_set_scrollbar_mode(cont, LV_SCROLLBAR_MODE_OFF);
+
+  for (int i = 0; i < BENCH_LABEL_LINES; i++) {
+    lv_obj_t *label = lv_label_create(cont);
+    lv_obj_set_style_text_font(label, font, 0);
+    lv_obj_set_style_text_color(label, hue(i * 23), 0);
+    lv_label_set_text_fmt(label, "%02d  The quick brown fox jumps over the "
+                                 "lazy dog 0123456789", i + 1);
+  }
+  lv_obj_update_layout(scr);
+  scene_obj = cont;
+  scroll_dir = 1;
+  return scr;
+}
+
+static lv_obj_t *label14_setup() {
+  return labels_setup(&lv_font_montserrat_14);
+}
+
+static lv_obj_t *label24_setup() {
+  return labels_setup(&lv_font_montserrat_24);
+}
+
+static void labels_step(uint32_t) {
+  // Bounce between top and bottom
+  if (scroll_dir > 0 && lv_obj_get_scroll_bottom(scene_obj) <= 0)
+    scroll_dir = -1;
+  else if (scroll_dir < 0 && lv_obj_get_scroll_y(scene_obj) <= 0)
+    scroll_dir = 1;
+  lv_obj_scroll_by_bounded(scene_obj, 0, -scroll_dir * BENCH_SCROLL_STEP,
+                           LV_ANIM_OFF);
+}
+
+// The real colour grid, focus moved one item per frame
+static lv_obj_t *focus_setup() {
+  screen_manager_show(screen_manager_find("grid"));
+  // The grid page's group holds just the gridnav container
+  scene_obj = lv_group_get_focused(lv_group_get_default());
+  return nullptr;
+}
+
+static void focus_step(uint32_t) {
+  if (!scene_obj)
+    return;
+  uint32_t key = LV_KEY_RIGHT;
+  lv_obj_send_event(scene_obj, LV_EVENT_KEY, &key);
+}
+
+static const bench_scene_t scenes[] = {
+    {"fill", fill_setup, fill_step},
+    {"gradient", gradient_setup, gradient_step},
+    {"alpha", alpha_setup, alpha_step},
+    {"label14", label14_setup, labels_step},
+    {"label24", label24_setup, labels_step},
+    {"focus", focus_setup, focus_step},
+};
+
+static void run_scene(lv_display_t *disp, const bench_scene_t *s) {
+  lv_obj_t *ui_screen = lv_screen_active();
+  int ui_page = screen_manager_active();
+  lv_obj_t *scr = s->setup();
+  if (scr)
+    lv_screen_load(scr);
+  lv_refr_now(disp);
+
+  uint32_t frame_total_us = 0;
+  uint32_t frame_max_us = 0;
+  uint32_t start_us = 0;
+  for (uint32_t f = 0; f < BENCH_WARMUP_FRAMES + BENCH_FRAMES; f++) {
+    if (f == BENCH_WARMUP_FRAMES) {
+      measuring = true;
+      flush_us = 0;
+      flush_count = 0;
+      flush_bytes = 0;
+      start_us = micros();
+    }
+    s->step(f);
+    uint32_t t0 = micros();
+    lv_refr_now(disp);
+    uint32_t frame_us = micros() - t0;
+    if (measuring) {
+      frame_total_us += frame_us;
+      if (frame_us > frame_max_us)
+        frame_max_us = frame_us;
+    }
+  }
+  uint32_t wall_us = micros() - start_us;
+  measuring = false;
+
+  // Flushes are synchronous, so what isn't flushing is rendering
+  uint32_t render_us = frame_total_us - flush_us;
+  Serial.printf("BENCH scene=%s frames=%u fps=%.1f frame_us=%lu "
+                "max_frame_us=%lu render_us=%lu flush_us=%lu flushes=%lu "
+                "bytes=%llu bytes_per_frame=%lu\n",
+                s->name, BENCH_FRAMES, BENCH_FRAMES * 1e6f / wall_us,
+                (unsigned long)(frame_total_us / BENCH_FRAMES),
+                (unsigned long)frame_max_us,
+                (unsigned long)(render_us / BENCH_FRAMES),
+                (unsigned long)(flush_us / BENCH_FRAMES),
+                (unsigned long)flush_count, (unsigned long long)flush_bytes,
+                (unsigned long)(flush_bytes / BENCH_FRAMES));
+
+  if (scr) {
+    // Back to the UI before the scene's screen goes away
+    lv_screen_load(ui_screen);
+    lv_obj_delete(scr);
+  } else if (ui_page >= 0) {
+    // The scene switched pages; go back to the one that was showing
+    screen_manager_show(ui_page);
+  }
+}
+
+static void run(lv_display_t *disp) {
+  Serial.printf("BENCH_BEGIN scenes=%u frames=%u width=%d height=%d\n",
+                (unsigned)(sizeof(scenes) / sizeof(scenes[0])), BENCH_FRAMES,
+                LCD_WIDTH, LCD_HEIGHT);
+  render_config_print();
+
+  // The focus scene moves focus on the real grid; don't save that
+  settings_suspend(true);
+  uint32_t t0 = millis();
+  for (const auto &s : scenes)
+    run_scene(disp, &s);
+  Serial.printf("BENCH_END total_ms=%lu\n", millis() - t0);
+  settings_suspend(false);
+
+  lv_obj_invalidate(lv_screen_active());
+}
+
+// One-shot flag: set by "bench", cleared when read at boot
+static bool take_request() {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false))
+    return false;
+  bool requested = prefs.getBool("run", false);
+  if (requested)
+    prefs.remove("run");
+  prefs.end();
+  return requested;
+}
+
+static void bench_command(const char *) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) {
+    Serial.println("Benchmark: NVS open failed");
+    return;
+  }
+  prefs.putBool("run", true);
+  prefs.end();
+  Serial.println("Benchmark: rebooting into benchmark mode");
+  Serial.flush();
+  delay(100);
+  ESP.restart();
+}
+
+void benchmark_begin(lv_display_t *disp) {
+  serial_console_register("bench", bench_command);
+
+  bool requested = take_request();
+#ifdef BENCHMARK_AT_BOOT
+  requested = true;
+#endif
+  if (requested)
+    run(disp);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Frames per scene: warm-up (not timed) and measured. Both are multiples
+// of the 9 grid items so focus cycling ends where it started.
+#define BENCH_WARMUP_FRAMES 9
+#define BENCH_FRAMES 108
+
+/**
+ * Register the "bench" console command (reboots into benchmark mode) and,
+ * if benchmark mode was selected for this boot, run every scene on the
+ * display and print one "BENCH ..." line per scene. Call at the end of
+ * setup() once the UI is up; the normal UI is shown again afterwards.
+ * Building with -DBENCHMARK_AT_BOOT runs it on every boot.
+ */
+void benchmark_begin(lv_display_t *disp);
+
+/**
+ * Account a flush (call from the flush callback with the panel push time)
+ */
+void benchmark_count_flush(uint32_t bytes, uint32_t push_us);
@@ -0,0 +1,75 @@
+#include "brightness_curve.h"
+#include <math.h>
+
+static uint8_t gamma_lut[256];
+
+void brightness_curve_init(float gamma) {
+  for (int i = 0; i < 256; i++) {
+    float v = powf(i / 255.0f, gamma) * 255.0f;
+    // Any non-zero level stays lit so the fade doesn't stall at black
+    if (i > 0 && v < 1.0f)
+      v = 1.0f;
+    gamma_lut[i] = (uint8_t)(v + 0.5f);
+  }
+}
+
+uint8_t brightness_to_panel(uint8_t level) { return gamma_lut[level]; }
+
+uint8_t brightness_from_panel(uint8_t value) {
+  // LUT is monotonic: find the first level that reaches value
+  int lo = 0, hi = 255;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (gamma_lut[mid] < value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  // The level just below may be closer
+  if (lo > 0 && value - gamma_lut[lo - 1] < gamma_lut[lo] - value)
+    lo--;
+  return (uint8_t)lo;
+}
+
+float ease_apply(ease_t ease, float t) {
+  if (t <= 0.0f)
+    return 0.0f;
+  if (t >= 1.0f)
+    return 1.0f;
+
+  switch (ease) {
+  case EASE_LINEAR:
+    return t;
+  case EASE_IN_OUT_CUBIC:
+    if (t < 0.5f)
+      return 4.0f * t * t * t;
+    t = 2.0f * t - 2.0f;
+    return 0.5f * t * t * t + 1.0f;
+  case EASE_OUT_CUBIC:
+    t = t - 1.0f;
+    return t * t * t + 1.0f;
+  }
+  return t;
+}
+
+void brightness_fade_start(brightness_fade_t *fade, float from, float to,
+                           uint32_t now_ms, uint32_t full_range_ms,
+                           ease_t ease) {
+  fade->from = from;
+  fade->to = to;
+  fade->start_ms = now_ms;
+  fade->duration_ms = (uint32_t)(fabsf(to - from) / 255.0f * full_range_ms);
+  fade->ease = ease;
+}
+
+float brightness_fade_level(const brightness_fade_t *fade, uint32_t now_ms) {
+  uint32_t elapsed = now_ms - fade->start_ms;
+  if (fade->duration_ms == 0 || elapsed >= fade->duration_ms)
+    return fade->to;
+  float t = (float)elapsed / fade->duration_ms;
+  return fade->from + (fade->to - fade->from) * ease_apply(fade->ease, t);
+}
+
+bool brightness_fade_done(const brightness_fade_t *fade, uint32_t now_ms) {
+  return now_ms - fade->start_ms >= fade->duration_ms;
+}
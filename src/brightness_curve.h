@@ -0,0 +1,63 @@
+#pragma once
+
+// Gamma mapping, easing and fade interpolation for brightness_engine.cpp.
+// Plain C++ with no Arduino dependencies so fade curves can be checked on
+// a host.
+
+#include <stdint.h>
+
+// Perceived lightness ~ panel_value^(1/gamma)
+#define BRIGHTNESS_GAMMA 2.2f
+
+enum ease_t {
+  EASE_LINEAR,
+  EASE_IN_OUT_CUBIC, // Gentle start and end
+  EASE_OUT_CUBIC,    // Fast start, gentle settle
+};
+
+// A fade in perceptual space (0.0 .. 255.0)
+struct brightness_fade_t {
+  float from;
+  float to;
+  uint32_t start_ms;
+  uint32_t duration_ms;
+  ease_t ease;
+};
+
+/**
+ * Build the perceptual -> panel lookup table
+ */
+void brightness_curve_init(float gamma);
+
+/**
+ * Panel register value (0x51) for a perceptual level
+ */
+uint8_t brightness_to_panel(uint8_t level);
+
+/**
+ * Closest perceptual level for a panel register value
+ */
+uint8_t brightness_from_panel(uint8_t value);
+
+/**
+ * Map linear progress t (0..1) through an easing curve
+ */
+float ease_apply(ease_t ease, float t);
+
+/**
+ * Start a fade from the given level. full_range_ms is the time for a
+ * 0 -> 255 sweep; shorter distances take proportionally less.
+ */
+void brightness_fade_start(brightness_fade_t *fade, float from, float to,
+                           uint32_t now_ms, uint32_t full_range_ms,
+                           ease_t ease);
+
+/**
+ * Perceptual level of the fade at now_ms
+ */
+float brightness_fade_level(const brightness_fade_t *fade, uint32_t now_ms);
+
+/**
+ * True once the fade has reached its target
+ */
+bool brightness_fade_done(const brightness_fade_t *fade, uint32_t now_ms);
@@ -0,0 +1,119 @@
+#include "brightness_engine.h"
+#include "display_gate.h"
+#include "qspi_display.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+static esp_timer_handle_t tick_timer = nullptr;
+static portMUX_TYPE fade_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Shared between the timer task and the main loop (guarded by fade_mux)
+static brightness_fade_t fade;
+static float cur_level = 0.0f; // Perceptual level last sampled
+static volatile bool fading = false;
+static uint8_t target_panel = 0; // Exact value to land on
+static volatile uint8_t pending_panel = 0; // Latest sample, not yet sent
+
+// Main loop only
+static uint8_t applied_panel = 0;
+
+// Samples the fade at a fixed rate regardless of how long the main loop
+// takes; the SPI write itself is left to brightness_engine_service().
+// One-shot, re-armed while the fade runs: the callback never stops the
+// timer, so it can't stop one a new fade_to() has just started.
+static void tick_cb(void *arg) {
+  uint32_t now = millis();
+
+  portENTER_CRITICAL(&fade_mux);
+  if (!fading) {
+    // brightness_engine_set() cancelled the fade while this tick was due
+    portEXIT_CRITICAL(&fade_mux);
+    return;
+  }
+  float level = brightness_fade_level(&fade, now);
+  bool done = brightness_fade_done(&fade, now);
+  cur_level = level;
+  pending_panel = brightness_to_panel((uint8_t)(level + 0.5f));
+  if (done) {
+    pending_panel = target_panel;
+    fading = false;
+  }
+  portEXIT_CRITICAL(&fade_mux);
+
+  // Fails harmlessly if fade_to() already re-armed it
+  if (!done)
+    esp_timer_start_once(tick_timer, BRIGHTNESS_TICK_US);
+}
+
+void brightness_engine_begin(uint8_t panel_value) {
+  brightness_curve_init(BRIGHTNESS_GAMMA);
+
+  esp_timer_create_args_t args = {};
+  args.callback = tick_cb;
+  args.name = "brightness";
+  if (esp_timer_create(&args, &tick_timer) != ESP_OK) {
+    Serial.println("Brightness timer create failed!");
+  }
+
+  brightness_engine_set(panel_value);
+}
+
+void brightness_engine_fade_to(uint8_t panel_value, uint32_t full_range_ms,
+                               ease_t ease) {
+  if (!tick_timer) {
+    brightness_engine_set(panel_value);
+    return;
+  }
+
+  esp_timer_stop(tick_timer); // Not running is fine
+
+  // Continue from wherever the previous fade got to
+  portENTER_CRITICAL(&fade_mux);
+  brightness_fade_start(&fade, cur_level, brightness_from_panel(panel_value),
+                        millis(), full_range_ms, ease);
+  target_panel = panel_value;
+  fading = true;
+  portEXIT_CRITICAL(&fade_mux);
+
+  esp_timer_start_once(tick_timer, BRIGHTNESS_TICK_US);
+}
+
+void brightness_engine_set(uint8_t panel_value) {
+  if (tick_timer)
+    esp_timer_stop(tick_timer);
+
+  portENTER_CRITICAL(&fade_mux);
+  fading = false;
+  cur_level = brightness_from_panel(panel_value);
+  target_panel = panel_value;
+  pending_panel = panel_value;
+  portEXIT_CRITICAL(&fade_mux);
+
+  applied_panel = panel_value;
+  display_gate_set_brightness(panel_value);
+}
+
+void brightness_engine_service(bool in_flush) {
+  uint8_t value = pending_panel;
+  if (value == applied_panel)
+    return;
+
+  if (in_flush) {
+    // Opening or closing the gate renders, which can't nest in a flush
+    bool visible = value >= DISPLAY_GATE_THRESHOLD;
+    if (visible != display_gate_is_open())
+      return;
+    applied_panel = value;
+    lcd.setBrightness(value);
+  } else {
+    // Mark applied first: opening the gate flushes, which calls back here
+    applied_panel = value;
+    display_gate_set_brightness(value);
+  }
+}
+
+bool brightness_engine_busy() {
+  return fading || pending_panel != applied_panel;
+}
+
+uint8_t brightness_engine_level() { return applied_panel; }
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "brightness_curve.h"
+#include <stdint.h>
+
+// Fade sample rate (esp_timer period)
+#define BRIGHTNESS_TICK_US 4000
+
+/**
+ * Build the gamma table and start at the given panel value
+ */
+void brightness_engine_begin(uint8_t panel_value);
+
+/**
+ * Fade to a panel value. Starts from the current level, so calling this
+ * mid-fade reverses smoothly. full_range_ms is the time for a full sweep.
+ */
+void brightness_engine_fade_to(uint8_t panel_value, uint32_t full_range_ms,
+                               ease_t ease);
+
+/**
+ * Jump to a panel value immediately (cancels any fade)
+ */
+void brightness_engine_set(uint8_t panel_value);
+
+/**
+ * Send the latest sampled level to the panel if it changed.
+ * in_flush: called between pixel bursts from the flush callback, where
+ * display gate transitions (which render) are left for the main loop.
+ */
+void brightness_engine_service(bool in_flush);
+
+/**
+ * True while a fade is running or its last level is not yet on the panel
+ */
+bool brightness_engine_busy();
+
+/**
+ * Panel value currently applied
+ */
+uint8_t brightness_engine_level();
@@ -0,0 +1,81 @@
+#include "display_gate.h"
+#include "qspi_display.h"
+#include <Arduino.h>
+
+static lv_display_t *gate_disp = nullptr;
+static bool gate_open = true;
+
+// Savings accounting for the current dark period
+static uint32_t dark_since_ms = 0;
+static uint32_t deferred_areas = 0;
+static uint32_t deferred_bytes = 0;  // Pixels that would have been pushed
+static uint32_t deferred_cycles = 0; // Refresh passes that would have run
+static uint32_t last_cycle_tick = 0;
+static uint32_t flushed_bytes = 0; // Bytes pushed to the panel (all time)
+
+static void invalidate_event_cb(lv_event_t *e) {
+  if (gate_open)
+    return;
+  const lv_area_t *area = lv_event_get_invalidated_area(e);
+  if (!area)
+    return;
+
+  deferred_areas++;
+  // Same pixel size as the flush callback counts (RGB565 on the panel)
+  deferred_bytes += lv_area_get_size(area) *
+                    lv_color_format_get_size(
+                        lv_display_get_color_format(gate_disp));
+
+  // Invalidations within one refresh period would have shared a render pass
+  if (deferred_cycles == 0 ||
+      lv_tick_elaps(last_cycle_tick) >= LV_DEF_REFR_PERIOD) {
+    deferred_cycles++;
+    last_cycle_tick = lv_tick_get();
+  }
+}
+
+void display_gate_begin(lv_display_t *disp) {
+  gate_disp = disp;
+  lv_display_add_event_cb(disp, invalidate_event_cb, LV_EVENT_INVALIDATE_AREA,
+                          NULL);
+}
+
+static void close_gate() {
+  gate_open = false;
+  lv_timer_pause(lv_display_get_refr_timer(gate_disp));
+  dark_since_ms = millis();
+  deferred_areas = 0;
+  deferred_bytes = 0;
+  deferred_cycles = 0;
+}
+
+// Render everything that piled up in one pass, then resume normal refresh
+static void open_gate() {
+  uint32_t before = flushed_bytes;
+  uint32_t t0 = micros();
+  gate_open = true;
+  lv_timer_resume(lv_display_get_refr_timer(gate_disp));
+  lv_refr_now(gate_disp);
+
+  Serial.printf("Display gate: dark %lu ms, deferred %lu areas (%lu bytes, "
+                "~%lu render passes) -> 1 pass, %lu bytes in %lu us\n",
+                millis() - dark_since_ms, (unsigned long)deferred_areas,
+                (unsigned long)deferred_bytes, (unsigned long)deferred_cycles,
+                (unsigned long)(flushed_bytes - before), micros() - t0);
+}
+
+void display_gate_set_brightness(uint8_t brightness) {
+  if (gate_disp) {
+    if (gate_open && brightness < DISPLAY_GATE_THRESHOLD) {
+      close_gate();
+    } else if (!gate_open && brightness >= DISPLAY_GATE_THRESHOLD) {
+      // Content must be on the panel before it becomes visible
+      open_gate();
+    }
+  }
+  lcd.setBrightness(brightness);
+}
+
+bool display_gate_is_open() { return gate_open; }
+
+void display_gate_count_flush(uint32_t bytes) { flushed_bytes += bytes; }
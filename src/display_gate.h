@@ -0,0 +1,28 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Below this brightness the panel counts as dark and rendering is deferred
+#define DISPLAY_GATE_THRESHOLD 16
+
+/**
+ * Hook the display so invalidations can be tracked while it is dark
+ */
+void display_gate_begin(lv_display_t *disp);
+
+/**
+ * Set panel brightness, pausing LVGL rendering when it drops below the
+ * threshold. Dirty areas accumulate while paused and are rendered and
+ * flushed in one pass just before the brightness rises above it again.
+ */
+void display_gate_set_brightness(uint8_t brightness);
+
+/**
+ * True while rendering and flushing are enabled
+ */
+bool display_gate_is_open();
+
+/**
+ * Account bytes pushed to the panel (call from the flush callback)
+ */
+void display_gate_count_flush(uint32_t bytes);
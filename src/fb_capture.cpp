@@ -0,0 +1,191 @@
+#include "fb_capture.h"
+#include "qspi_display.h"
+#include "serial_console.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <string.h>
+
+// Room kept free in a buffer for the frame-end packet
+#define FRAME_END_SIZE (sizeof(fb_packet_header_t) + sizeof(fb_frame_stats_t))
+
+static bool active = false;
+static uint16_t *shadow = nullptr; // What the panel currently shows
+static uint8_t *bufs[CAPTURE_BUFFER_COUNT];
+static uint32_t buf_len[CAPTURE_BUFFER_COUNT];
+static QueueHandle_t free_q = nullptr; // Buffer indices ready for a frame
+static QueueHandle_t send_q = nullptr; // Buffer indices waiting for USB
+
+// Current frame
+static int8_t cur = -1; // Buffer being filled (-1 = none yet)
+static bool frame_failed = false;
+static bool frame_key = false;
+static uint32_t frame_no = 0;
+static fb_frame_stats_t stats;
+
+// Key frame scheduling (start, host request, or after a drop)
+static bool key_requested = false;
+static bool key_armed = false;
+static uint32_t dropped_total = 0;
+
+// Ships finished frames; the only place that can block on the host
+static void sender_task(void *arg) {
+  int8_t idx;
+  for (;;) {
+    if (xQueueReceive(send_q, &idx, portMAX_DELAY) == pdTRUE) {
+      Serial.write(bufs[idx], buf_len[idx]);
+      xQueueSend(free_q, &idx, 0);
+    }
+  }
+}
+
+static bool alloc_buffers() {
+  if (shadow)
+    return true;
+
+  shadow = (uint16_t *)heap_caps_malloc(LCD_WIDTH * LCD_HEIGHT * 2,
+                                        MALLOC_CAP_SPIRAM);
+  for (int i = 0; i < CAPTURE_BUFFER_COUNT; i++)
+    bufs[i] = (uint8_t *)heap_caps_malloc(CAPTURE_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+  free_q = xQueueCreate(CAPTURE_BUFFER_COUNT, sizeof(int8_t));
+  send_q = xQueueCreate(CAPTURE_BUFFER_COUNT, sizeof(int8_t));
+
+  bool ok = shadow && free_q && send_q;
+  for (int i = 0; i < CAPTURE_BUFFER_COUNT; i++)
+    ok = ok && bufs[i];
+  if (!ok) {
+    Serial.println("Capture: buffer allocation failed");
+    return false;
+  }
+
+  for (int8_t i = 0; i < CAPTURE_BUFFER_COUNT; i++)
+    xQueueSend(free_q, &i, 0);
+  // Core 0, away from the LVGL loop on core 1
+  xTaskCreatePinnedToCore(sender_task, "fb_capture", 4096, NULL, 1, NULL, 0);
+  return true;
+}
+
+static void capture_command(const char *args) {
+  if (strcmp(args, "on") == 0) {
+    if (!alloc_buffers())
+      return;
+    Serial.println("Capture: on");
+    active = true;
+    key_requested = true;
+    dropped_total = 0;
+  } else if (strcmp(args, "off") == 0) {
+    active = false;
+    Serial.println("Capture: off");
+  } else if (strcmp(args, "key") == 0) {
+    key_requested = true;
+  } else {
+    Serial.println("usage: capture on|off|key");
+  }
+}
+
+static void display_event_cb(lv_event_t *e) {
+  if (!active)
+    return;
+
+  if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+    cur = -1;
+    // Deltas are useless to a host that missed a frame; wait for the key
+    frame_failed = key_requested;
+    frame_key = key_armed;
+    key_armed = false;
+    memset(&stats, 0, sizeof(stats));
+    return;
+  }
+
+  // LV_EVENT_REFR_READY: ship the frame if anything was flushed
+  if (cur < 0)
+    return;
+  fb_packet_header_t *hdr = (fb_packet_header_t *)(bufs[cur] + buf_len[cur]);
+  fb_frame_stats_t *payload = (fb_frame_stats_t *)(hdr + 1);
+  stats.dropped = dropped_total;
+  *payload = stats;
+  fb_fill_header(hdr, FB_PACKET_FRAME_END, frame_key ? FB_FLAG_KEY : 0,
+                 frame_no, 0, 0, LCD_WIDTH, LCD_HEIGHT, (uint8_t *)payload,
+                 sizeof(*payload));
+  buf_len[cur] += FRAME_END_SIZE;
+
+  xQueueSend(send_q, &cur, 0);
+  cur = -1;
+  frame_no++;
+}
+
+void fb_capture_begin(lv_display_t *disp) {
+  lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_REFR_START, NULL);
+  lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_REFR_READY, NULL);
+  serial_console_register("capture", capture_command);
+}
+
+// The host missed part of the picture: resend everything on the next frame
+static void drop_frame() {
+  if (cur >= 0) {
+    xQueueSend(free_q, &cur, 0);
+    cur = -1;
+  }
+  frame_failed = true;
+  key_requested = true;
+  dropped_total++;
+}
+
+void fb_capture_area(const lv_area_t *area, const uint16_t *px,
+                     uint32_t stride, uint32_t push_us) {
+  if (!active)
+    return;
+
+  uint32_t t0 = micros();
+  uint16_t w = lv_area_get_width(area);
+  uint16_t h = lv_area_get_height(area);
+  uint16_t *ref = shadow + area->y1 * LCD_WIDTH + area->x1;
+
+  // Take a buffer on the first area; none free means the host is behind
+  if (cur < 0 && !frame_failed) {
+    int8_t idx;
+    if (xQueueReceive(free_q, &idx, 0) == pdTRUE) {
+      cur = idx;
+      buf_len[cur] = 0;
+    } else {
+      drop_frame();
+    }
+  }
+
+  if (cur >= 0) {
+    fb_packet_header_t *hdr = (fb_packet_header_t *)(bufs[cur] + buf_len[cur]);
+    uint8_t *payload = (uint8_t *)(hdr + 1);
+    size_t room = CAPTURE_BUFFER_SIZE - buf_len[cur] - sizeof(*hdr) -
+                  FRAME_END_SIZE;
+    size_t len = fb_encode_area(px, stride, frame_key ? nullptr : ref,
+                                LCD_WIDTH, w, h, payload, room);
+    if (len == 0) {
+      drop_frame();
+    } else {
+      fb_fill_header(hdr, FB_PACKET_AREA, frame_key ? FB_FLAG_KEY : 0,
+                     frame_no, area->x1, area->y1, w, h, payload, len);
+      buf_len[cur] += sizeof(*hdr) + len;
+      stats.bytes += sizeof(*hdr) + len;
+    }
+  }
+
+  // Keep the reference in step with the panel even for dropped frames
+  for (uint16_t row = 0; row < h; row++)
+    memcpy(ref + row * LCD_WIDTH, px + row * stride, w * sizeof(uint16_t));
+
+  stats.areas++;
+  stats.raw_bytes += w * h * sizeof(uint16_t);
+  stats.push_us += push_us;
+  stats.encode_us += micros() - t0;
+}
+
+void fb_capture_poll() {
+  if (active && key_requested) {
+    key_requested = false;
+    key_armed = true;
+    lv_obj_invalidate(lv_screen_active());
+  }
+}
+
+bool fb_capture_active() { return active; }
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "fb_codec.h"
+#include <lvgl.h>
+
+// One frame's packets are collected here before the sender task ships
+// them (a full-screen key frame needs ~260 KB)
+#define CAPTURE_BUFFER_SIZE (300 * 1024)
+#define CAPTURE_BUFFER_COUNT 2
+
+/**
+ * Hook frame start/end on the display and register the "capture" console
+ * command ("capture on|off|key")
+ */
+void fb_capture_begin(lv_display_t *disp);
+
+/**
+ * Encode a flushed area (call from the flush callback after the push)
+ * px/stride address the area's first pixel; push_us is the panel push time
+ */
+void fb_capture_area(const lv_area_t *area, const uint16_t *px,
+                     uint32_t stride, uint32_t push_us);
+
+/**
+ * Schedule a full-screen key frame when one is needed (call every loop)
+ */
+void fb_capture_poll();
+
+/**
+ * True while frames are being streamed
+ */
+bool fb_capture_active();
@@ -0,0 +1,131 @@
+#include "fb_codec.h"
+#include <string.h>
+
+// Shorter skips/runs cost more than sending the pixels as literals
+#define MIN_SKIP 2
+#define MIN_RUN 3
+
+struct writer_t {
+  uint8_t *out;
+  size_t pos;
+  size_t cap;
+  bool overflow;
+};
+
+static void put_byte(writer_t *w, uint8_t b) {
+  if (w->pos >= w->cap) {
+    w->overflow = true;
+    return;
+  }
+  w->out[w->pos++] = b;
+}
+
+static void put_varint(writer_t *w, uint32_t v) {
+  while (v >= 0x80) {
+    put_byte(w, (uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  put_byte(w, (uint8_t)v);
+}
+
+static void put_pixels(writer_t *w, const uint16_t *px, uint32_t n) {
+  size_t bytes = n * sizeof(uint16_t);
+  if (w->pos + bytes > w->cap) {
+    w->overflow = true;
+    return;
+  }
+  memcpy(w->out + w->pos, px, bytes);
+  w->pos += bytes;
+}
+
+static void put_literal(writer_t *w, const uint16_t *px, uint32_t n) {
+  if (n == 0)
+    return;
+  put_byte(w, FB_TOKEN_LITERAL);
+  put_varint(w, n);
+  put_pixels(w, px, n);
+}
+
+size_t fb_encode_area(const uint16_t *src, uint32_t src_stride,
+                      const uint16_t *ref, uint32_t ref_stride, uint16_t w,
+                      uint16_t h, uint8_t *out, size_t cap) {
+  writer_t wr = {out, 0, cap, false};
+
+  for (uint16_t row = 0; row < h && !wr.overflow; row++) {
+    const uint16_t *s = src + row * src_stride;
+    const uint16_t *r = ref ? ref + row * ref_stride : nullptr;
+    uint32_t lit_start = 0, lit_len = 0;
+    uint32_t x = 0;
+
+    while (x < w) {
+      if (r) {
+        uint32_t k = 0;
+        while (x + k < w && s[x + k] == r[x + k])
+          k++;
+        if (k >= MIN_SKIP || (k > 0 && x + k == w)) {
+          put_literal(&wr, s + lit_start, lit_len);
+          lit_len = 0;
+          put_byte(&wr, FB_TOKEN_SKIP);
+          put_varint(&wr, k);
+          x += k;
+          continue;
+        }
+      }
+
+      uint32_t k = 1;
+      while (x + k < w && s[x + k] == s[x])
+        k++;
+      if (k >= MIN_RUN) {
+        put_literal(&wr, s + lit_start, lit_len);
+        lit_len = 0;
+        put_byte(&wr, FB_TOKEN_RUN);
+        put_varint(&wr, k);
+        put_pixels(&wr, s + x, 1);
+        x += k;
+        continue;
+      }
+
+      if (lit_len == 0)
+        lit_start = x;
+      lit_len++;
+      x++;
+    }
+    put_literal(&wr, s + lit_start, lit_len);
+  }
+
+  return wr.overflow ? 0 : wr.pos;
+}
+
+void fb_fill_header(fb_packet_header_t *hdr, uint8_t type, uint8_t flags,
+                    uint32_t frame, uint16_t x, uint16_t y, uint16_t w,
+                    uint16_t h, const uint8_t *payload, uint32_t length) {
+  hdr->magic[0] = FB_MAGIC0;
+  hdr->magic[1] = FB_MAGIC1;
+  hdr->type = type;
+  hdr->flags = flags;
+  hdr->frame = frame;
+  hdr->x = x;
+  hdr->y = y;
+  hdr->w = w;
+  hdr->h = h;
+  hdr->length = length;
+  hdr->payload_sum = fb_fletcher16(payload, length);
+  hdr->header_sum = fb_fletcher16((const uint8_t *)hdr,
+                                  offsetof(fb_packet_header_t, header_sum));
+}
+
+uint16_t fb_fletcher16(const uint8_t *data, size_t len) {
+  uint32_t a = 0, b = 0;
+  while (len) {
+    // Reduce only every few hundred bytes; the sums can't overflow before
+    size_t n = len < 360 ? len : 360;
+    len -= n;
+    while (n--) {
+      a += *data++;
+      b += a;
+    }
+    a %= 255;
+    b %= 255;
+  }
+  return (uint16_t)((b << 8) | a);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Delta + RLE encoding of flushed areas for fb_capture.cpp, and the packet
+// framing shared with tools/fb_capture.py. Plain C++ with no Arduino
+// dependencies so the encoder can be exercised on a host.
+//
+// Area payload: per row, a sequence of tokens covering exactly w pixels
+//   0x00 <varint n>             skip n pixels (unchanged from reference)
+//   0x01 <varint n> <px>        n copies of one RGB565 pixel
+//   0x02 <varint n> <px * n>    n literal RGB565 pixels
+// Pixels are sent as stored in the LVGL buffer (little-endian RGB565).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FB_MAGIC0 'F'
+#define FB_MAGIC1 'B'
+
+enum fb_packet_type_t {
+  FB_PACKET_AREA = 1,      // Encoded area of the current frame
+  FB_PACKET_FRAME_END = 2, // Frame complete, payload is fb_frame_stats_t
+};
+
+// Area was encoded without a reference (no skip tokens)
+#define FB_FLAG_KEY 0x01
+
+enum fb_token_t {
+  FB_TOKEN_SKIP = 0x00,
+  FB_TOKEN_RUN = 0x01,
+  FB_TOKEN_LITERAL = 0x02,
+};
+
+struct __attribute__((packed)) fb_packet_header_t {
+  uint8_t magic[2];
+  uint8_t type;
+  uint8_t flags;
+  uint32_t frame;
+  uint16_t x, y, w, h;
+  uint32_t length;      // Payload bytes following the header
+  uint16_t payload_sum; // Fletcher-16 of the payload
+  uint16_t header_sum;  // Fletcher-16 of the header up to this field
+};
+
+struct __attribute__((packed)) fb_frame_stats_t {
+  uint32_t areas;
+  uint32_t bytes;     // Encoded payload bytes this frame
+  uint32_t raw_bytes; // Unencoded RGB565 bytes this frame
+  uint32_t encode_us; // Time spent encoding (added to flush)
+  uint32_t push_us;   // Time spent pushing pixels to the panel
+  uint32_t dropped;   // Frames dropped so far (host too slow)
+};
+
+/**
+ * Encode a w x h area. ref (same geometry as src, may be NULL) holds the
+ * previous contents; unchanged pixels become skip tokens.
+ * Returns the payload size, or 0 if it would not fit in cap.
+ */
+size_t fb_encode_area(const uint16_t *src, uint32_t src_stride,
+                      const uint16_t *ref, uint32_t ref_stride, uint16_t w,
+                      uint16_t h, uint8_t *out, size_t cap);
+
+/**
+ * Fill in a packet header for a payload that is already in place
+ */
+void fb_fill_header(fb_packet_header_t *hdr, uint8_t type, uint8_t flags,
+                    uint32_t frame, uint16_t x, uint16_t y, uint16_t w,
+                    uint16_t h, const uint8_t *payload, uint32_t length);
+
+uint16_t fb_fletcher16(const uint8_t *data, size_t len);
@@ -0,0 +1,37 @@
+#include "governor_policy.h"
+
+void governor_policy_init(governor_policy_t *policy, uint32_t now_ms) {
+  policy->profile = PROFILE_PERFORMANCE;
+  policy->last_busy_ms = now_ms;
+  policy->switches = 0;
+}
+
+bool governor_policy_step(governor_policy_t *policy,
+                          const governor_sample_t *sample) {
+  bool busy = sample->input || sample->animating || sample->fading;
+  if (busy)
+    policy->last_busy_ms = sample->now_ms;
+
+  perf_profile_t next = policy->profile;
+  if (busy) {
+    next = PROFILE_PERFORMANCE;
+  } else if (sample->now_ms - policy->last_busy_ms >= GOVERNOR_QUIET_AFTER_MS) {
+    next = PROFILE_QUIET;
+  }
+
+  if (next == policy->profile)
+    return false;
+  policy->profile = next;
+  policy->switches++;
+  return true;
+}
+
+const char *governor_profile_name(perf_profile_t profile) {
+  switch (profile) {
+  case PROFILE_PERFORMANCE:
+    return "PERFORMANCE";
+  case PROFILE_QUIET:
+    return "QUIET";
+  }
+  return "?";
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Performance profile decision logic for perf_governor.cpp.
+// Plain C++ with no Arduino/LVGL dependencies so recorded activity traces
+// can be replayed through it on a host.
+
+#include <stdint.h>
+
+// No input/animation for this long drops to the quiet profile
+#define GOVERNOR_QUIET_AFTER_MS 2000
+
+enum perf_profile_t {
+  PROFILE_PERFORMANCE = 0, // Input or animations in progress
+  PROFILE_QUIET = 1,       // Static screen
+};
+
+// One observation per main-loop pass
+struct governor_sample_t {
+  uint32_t now_ms;
+  bool input;     // Trackball activity seen this pass
+  bool animating; // LVGL animations running
+  bool fading;    // Panel brightness fade in progress
+};
+
+struct governor_policy_t {
+  perf_profile_t profile;
+  uint32_t last_busy_ms;
+  uint32_t switches;
+};
+
+/**
+ * Start in the performance profile as if activity just happened
+ */
+void governor_policy_init(governor_policy_t *policy, uint32_t now_ms);
+
+/**
+ * Feed one sample; returns true if the profile changed
+ * Any activity switches to performance immediately, quiet needs
+ * GOVERNOR_QUIET_AFTER_MS without activity.
+ */
+bool governor_policy_step(governor_policy_t *policy,
+                          const governor_sample_t *sample);
+
+/**
+ * Human-readable profile name for logs
+ */
+const char *governor_profile_name(perf_profile_t profile);
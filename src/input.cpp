@@ -1,5 +1,6 @@
 #include "input.h"
 #include "trackball.h"
+#include "trackball_led.h"
 #include <Arduino.h>
 
 // External trackball instance (defined in main.cpp)
@@ -14,6 +15,10 @@ static const int16_t NAVIGATION_THRESHOLD = 4;
 // Minimum key press duration in milliseconds
 static const uint32_t KEY_PRESS_DURATION_MS = 50;
 
+// LED acknowledgement for a trackball click
+static const led_rgbw_t CLICK_FLASH_COLOR = {{255, 255, 255, 255}};
+static const uint32_t CLICK_FLASH_MS = 80;
+
 void keypad_read(lv_indev_t *indev, lv_indev_data_t *data) {
   static int16_t acc_x = 0;
   static int16_t acc_y = 0;
@@ -62,6 +67,9 @@ void keypad_read(lv_indev_t *indev, lv_indev_data_t *data) {
   // Check for button press (highest priority)
   if (trackball.isPressed()) {
     Serial.println("Trackball: PRESSED -> LV_KEY_ENTER");
+    // Acknowledge on the ENTER press itself; clicked() only lasts one
+    // update and is usually consumed while a key is still being held
+    trackball_led_flash(CLICK_FLASH_COLOR, CLICK_FLASH_MS);
     data->state = LV_INDEV_STATE_PRESSED;
     data->key = LV_KEY_ENTER;
     last_key = LV_KEY_ENTER;
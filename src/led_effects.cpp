@@ -0,0 +1,195 @@
+#include "led_effects.h"
+#include <string.h>
+
+// Blend a -> b by pos/256
+static led_rgbw_t mix(const led_rgbw_t &a, const led_rgbw_t &b, uint32_t pos) {
+  led_rgbw_t out;
+  for (int i = 0; i < LED_CHANNELS; i++) {
+    out.c[i] = (uint8_t)((a.c[i] * (256 - pos) + b.c[i] * pos) >> 8);
+  }
+  return out;
+}
+
+// Progress 0..256 through [start, start + duration)
+static uint32_t progress(uint32_t now_ms, uint32_t start_ms,
+                         uint32_t duration_ms) {
+  uint32_t elapsed = now_ms - start_ms;
+  if (duration_ms == 0 || elapsed >= duration_ms)
+    return 256;
+  return (elapsed << 8) / duration_ms;
+}
+
+// Triangle 0 -> 256 -> 0 with smoothstep shaping
+static uint32_t swell(uint32_t pos) {
+  uint32_t x = pos < 128 ? pos * 2 : (256 - pos) * 2;
+  return (x * x * (768 - 2 * x)) >> 16;
+}
+
+void led_effects_init(led_effects_t *fx, led_rgbw_t color) {
+  memset(fx, 0, sizeof(*fx));
+  led_effects_solid(fx, color);
+  fx->last = color;
+}
+
+led_rgbw_t led_effects_frame(led_effects_t *fx, uint32_t now_ms) {
+  led_effect_t *e = &fx->base;
+  led_rgbw_t out = e->to;
+
+  switch (e->type) {
+  case LED_EFFECT_SOLID:
+    break;
+  case LED_EFFECT_TRANSITION: {
+    uint32_t pos = progress(now_ms, e->start_ms, e->duration_ms);
+    out = mix(e->from, e->to, pos);
+    if (pos >= 256)
+      led_effects_solid(fx, e->to);
+    break;
+  }
+  case LED_EFFECT_PULSE: {
+    uint32_t pos = progress(now_ms, e->start_ms, e->duration_ms);
+    out = mix(e->from, e->to, swell(pos));
+    if (pos >= 256)
+      led_effects_solid(fx, e->from);
+    break;
+  }
+  case LED_EFFECT_BREATHE: {
+    uint32_t period = e->duration_ms ? e->duration_ms : 1;
+    uint32_t phase = (now_ms - e->start_ms) % period;
+    out = mix(e->from, e->to, swell((phase << 8) / period));
+    break;
+  }
+  }
+  fx->base_last = out;
+
+  if (fx->flash_active) {
+    if (now_ms - fx->flash_start_ms < fx->flash_ms)
+      out = fx->flash_color;
+    else
+      fx->flash_active = false;
+  }
+
+  fx->last = out;
+  return out;
+}
+
+bool led_effects_animating(const led_effects_t *fx) {
+  return fx->base.type != LED_EFFECT_SOLID || fx->flash_active;
+}
+
+void led_effects_solid(led_effects_t *fx, led_rgbw_t color) {
+  fx->base.type = LED_EFFECT_SOLID;
+  fx->base.from = color;
+  fx->base.to = color;
+  fx->base.duration_ms = 0;
+  fx->base_last = color;
+}
+
+void led_effects_transition(led_effects_t *fx, led_rgbw_t to, uint32_t now_ms,
+                            uint32_t duration_ms) {
+  // Start from the base effect's current colour so retargeting mid-effect
+  // doesn't jump; a flash on top (the click acknowledgement) isn't part of it
+  fx->base.type = LED_EFFECT_TRANSITION;
+  fx->base.from = fx->base_last;
+  fx->base.to = to;
+  fx->base.start_ms = now_ms;
+  fx->base.duration_ms = duration_ms;
+}
+
+void led_effects_pulse(led_effects_t *fx, led_rgbw_t color, uint32_t now_ms,
+                       uint32_t duration_ms) {
+  led_rgbw_t rest = fx->base.to;
+  if (fx->base.type == LED_EFFECT_PULSE)
+    rest = fx->base.from; // Restarted pulse returns to the original colour
+  fx->base.type = LED_EFFECT_PULSE;
+  fx->base.from = rest;
+  fx->base.to = color;
+  fx->base.start_ms = now_ms;
+  fx->base.duration_ms = duration_ms;
+}
+
+void led_effects_breathe(led_effects_t *fx, led_rgbw_t color, uint32_t now_ms,
+                         uint32_t period_ms) {
+  fx->base.type = LED_EFFECT_BREATHE;
+  memset(&fx->base.from, 0, sizeof(fx->base.from));
+  fx->base.to = color;
+  fx->base.start_ms = now_ms;
+  fx->base.duration_ms = period_ms;
+}
+
+void led_effects_flash(led_effects_t *fx, led_rgbw_t color, uint32_t now_ms,
+                       uint32_t flash_ms) {
+  fx->flash_active = true;
+  fx->flash_color = color;
+  fx->flash_start_ms = now_ms;
+  fx->flash_ms = flash_ms;
+}
+
+void led_writer_init(led_writer_t *writer, uint32_t budget_per_s,
+                     uint32_t now_ms) {
+  memset(writer, 0, sizeof(*writer));
+  writer->budget_per_s = budget_per_s;
+  writer->tokens = LED_WRITER_BURST * 1000;
+  writer->last_refill_ms = now_ms;
+}
+
+static void refill(led_writer_t *writer, uint32_t now_ms) {
+  uint32_t elapsed = now_ms - writer->last_refill_ms;
+  writer->last_refill_ms = now_ms;
+  uint32_t cap = LED_WRITER_BURST * 1000;
+  // Clamp before multiplying so long idle gaps can't overflow
+  if (elapsed > cap)
+    elapsed = cap;
+  writer->tokens += elapsed * writer->budget_per_s;
+  if (writer->tokens > cap)
+    writer->tokens = cap;
+}
+
+static void fill_write(led_writer_t *writer, const led_rgbw_t *frame, int lo,
+                       int hi, led_write_t *out) {
+  out->first = (uint8_t)lo;
+  out->count = (uint8_t)(hi - lo + 1);
+  for (int i = lo; i <= hi; i++)
+    out->values[i - lo] = frame->c[i];
+
+  writer->sent = *frame;
+  writer->synced = true;
+  writer->writes++;
+  writer->bytes += 1 + out->count;
+}
+
+bool led_writer_plan(led_writer_t *writer, const led_rgbw_t *frame,
+                     uint32_t now_ms, led_write_t *out) {
+  writer->frames++;
+  refill(writer, now_ms);
+
+  // Span of channels that differ from what the LED holds
+  int lo = 0, hi = LED_CHANNELS - 1;
+  if (writer->synced) {
+    lo = -1;
+    for (int i = 0; i < LED_CHANNELS; i++) {
+      if (frame->c[i] != writer->sent.c[i]) {
+        if (lo < 0)
+          lo = i;
+        hi = i;
+      }
+    }
+    if (lo < 0) {
+      writer->skipped_same++;
+      return false;
+    }
+  }
+
+  if (writer->tokens < 1000) {
+    writer->skipped_budget++;
+    return false;
+  }
+  writer->tokens -= 1000;
+
+  fill_write(writer, frame, lo, hi, out);
+  return true;
+}
+
+void led_writer_force(led_writer_t *writer, const led_rgbw_t *frame,
+                      led_write_t *out) {
+  fill_write(writer, frame, 0, LED_CHANNELS - 1, out);
+}
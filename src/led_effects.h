@@ -0,0 +1,111 @@
+#pragma once
+
+// Trackball LED frame generation and I2C write planning for
+// trackball_led.cpp. Plain C++ with no Arduino dependencies so effects and
+// write deduplication can be checked on a host.
+
+#include <stdint.h>
+
+// Channel order matches the trackball LED registers (0x00..0x03)
+enum { LED_R = 0, LED_G, LED_B, LED_W, LED_CHANNELS };
+
+struct led_rgbw_t {
+  uint8_t c[LED_CHANNELS];
+};
+
+enum led_effect_type_t {
+  LED_EFFECT_SOLID,
+  LED_EFFECT_TRANSITION, // Cross-fade from -> to, then solid
+  LED_EFFECT_PULSE,      // One rise/fall to a colour, then back to from
+  LED_EFFECT_BREATHE,    // Continuous swell between off and a colour
+};
+
+struct led_effect_t {
+  led_effect_type_t type;
+  led_rgbw_t from;
+  led_rgbw_t to;
+  uint32_t start_ms;
+  uint32_t duration_ms; // Period for BREATHE
+};
+
+struct led_effects_t {
+  led_effect_t base;
+  // Acknowledgement flash shown on top of the base effect
+  bool flash_active;
+  led_rgbw_t flash_color;
+  uint32_t flash_start_ms;
+  uint32_t flash_ms;
+  led_rgbw_t base_last; // Last base-effect colour, under any flash
+  led_rgbw_t last;      // Last frame produced
+};
+
+/**
+ * Start with a solid colour
+ */
+void led_effects_init(led_effects_t *fx, led_rgbw_t color);
+
+/**
+ * Compute the frame for now_ms (finished effects settle to solid)
+ */
+led_rgbw_t led_effects_frame(led_effects_t *fx, uint32_t now_ms);
+
+/**
+ * True while the output can still change without a new effect call
+ */
+bool led_effects_animating(const led_effects_t *fx);
+
+void led_effects_solid(led_effects_t *fx, led_rgbw_t color);
+void led_effects_transition(led_effects_t *fx, led_rgbw_t to, uint32_t now_ms,
+                            uint32_t duration_ms);
+void led_effects_pulse(led_effects_t *fx, led_rgbw_t color, uint32_t now_ms,
+                       uint32_t duration_ms);
+void led_effects_breathe(led_effects_t *fx, led_rgbw_t color, uint32_t now_ms,
+                         uint32_t period_ms);
+void led_effects_flash(led_effects_t *fx, led_rgbw_t color, uint32_t now_ms,
+                       uint32_t flash_ms);
+
+// Token bucket allows short bursts of this many writes
+#define LED_WRITER_BURST 3
+
+// One I2C write: a run of consecutive LED registers
+struct led_write_t {
+  uint8_t first; // First register (channel index)
+  uint8_t count;
+  uint8_t values[LED_CHANNELS];
+};
+
+struct led_writer_t {
+  led_rgbw_t sent; // What the LED controller holds
+  bool synced;     // sent is known (false until the first write)
+  uint32_t budget_per_s;
+  uint32_t tokens; // 1000 per write
+  uint32_t last_refill_ms;
+
+  // Statistics
+  uint32_t frames;
+  uint32_t writes;
+  uint32_t bytes;          // Payload incl. register byte
+  uint32_t skipped_same;   // Frames identical to what the LED shows
+  uint32_t skipped_budget; // Frames dropped because the budget was spent
+};
+
+/**
+ * Reset state with a write budget in writes per second
+ */
+void led_writer_init(led_writer_t *writer, uint32_t budget_per_s,
+                     uint32_t now_ms);
+
+/**
+ * Decide whether frame needs a write. Returns true and fills out (only the
+ * changed span of channels) if it does and the budget allows; the caller
+ * must then perform the write. Skipped frames are not queued: the next
+ * frame is diffed against what was actually sent.
+ */
+bool led_writer_plan(led_writer_t *writer, const led_rgbw_t *frame,
+                     uint32_t now_ms, led_write_t *out);
+
+/**
+ * Record an unconditional full write (bypasses the budget)
+ */
+void led_writer_force(led_writer_t *writer, const led_rgbw_t *frame,
+                      led_write_t *out);
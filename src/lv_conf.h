@@ -13,12 +13,20 @@
    MEMORY SETTINGS
  *====================*/
 #define LV_MEM_CUSTOM 0
-#define LV_MEM_SIZE (64 * 1024U)
+#define LV_MEM_SIZE (64 * 1024U) // Builtin allocator only
+
+// 1: tiered internal-RAM/PSRAM heaps with profiling (src/mem_tiered.cpp)
+// 0: LVGL's builtin LV_MEM_SIZE heap in internal RAM
+#define LV_MEM_TIERED 1
 
 /*====================
    STDLIB - REQUIRED FOR LVGL 9
  *====================*/
+#if LV_MEM_TIERED
+#define LV_USE_STDLIB_MALLOC    LV_STDLIB_CUSTOM
+#else
 #define LV_USE_STDLIB_MALLOC    LV_STDLIB_BUILTIN
+#endif
 #define LV_USE_STDLIB_STRING    LV_STDLIB_BUILTIN
 #define LV_USE_STDLIB_SPRINTF   LV_STDLIB_BUILTIN
 
@@ -60,6 +68,7 @@
    EXTRAS
  *====================*/
 #define LV_USE_GRIDNAV 1
+#define LV_USE_SNAPSHOT 1
 
 /*====================
    GROUPS - REQUIRED FOR INPUT
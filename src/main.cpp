@@ -1,6 +1,21 @@
+#include "asset_pack.h"
+#include "battery_governor.h"
+#include "benchmark.h"
+#include "brightness_engine.h"
+#include "display_gate.h"
+#include "fb_capture.h"
 #include "input.h"
+#include "mem_tiered.h"
+#include "ota_update.h"
+#include "perf_governor.h"
 #include "qspi_display.h"
+#include "render_config.h"
+#include "screen_manager.h"
+#include "serial_console.h"
+#include "settings.h"
+#include "stall_watch.h"
 #include "trackball.h"
+#include "trackball_led.h"
 #include "ui.h"
 #include <Arduino.h>
 #include <Wire.h>
@@ -14,16 +29,9 @@
 #define I2C_SDA 40
 #define I2C_SCL 39
 
-// Buffer height for partial rendering (60 lines each)
-#define BUF_HEIGHT 60
-
 // Power management settings
-#define IDLE_TIMEOUT_MS 10000 // 10 seconds
-#define FADE_OUT_STEP 8       // Brightness reduction per step
-#define FADE_IN_STEP 12       // Brightness increase per step
-#define FADE_OUT_INTERVAL_MS 20
-#define FADE_IN_INTERVAL_MS 10
-#define TARGET_BRIGHTNESS 200
+#define FADE_OUT_MS 600       // Full-range fade durations (perceptual)
+#define FADE_IN_MS 250
 
 // Trackball instance (global, used by ui.cpp and input.cpp)
 Trackball trackball;
@@ -31,24 +39,55 @@ Trackball trackball;
 // Global activity flag that input.cpp can set
 volatile bool g_activity_detected = false;
 
-// Saved LED color for restoring after wake
-static uint8_t saved_led_r = 0;
-static uint8_t saved_led_g = 0;
-static uint8_t saved_led_b = 64; // Default blue
-static uint8_t saved_led_w = 0;
+// LED colour picked in the UI (persisted in settings)
+static led_rgbw_t saved_led_color() {
+  const uint8_t *c = settings_get()->led;
+  return {{c[0], c[1], c[2], c[3]}};
+}
+
+// Cross-fade time when a new LED colour is picked
+#define LED_COLOR_TRANSITION_MS 200
 
 /* Display flushing callback for LVGL 9 */
 void disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
   uint32_t w = lv_area_get_width(area);
   uint32_t h = lv_area_get_height(area);
 
-  lcd.setWindow(area->x1, area->y1, w, h);
-  lcd.pushPixels((uint16_t *)px_map, w * h);
+  uint16_t *px = (uint16_t *)px_map;
+  uint32_t stride = w;
+  if (render_config_active()->mode == LV_DISPLAY_RENDER_MODE_DIRECT) {
+    // px_map is the whole frame buffer; send only the dirty window
+    px += area->y1 * LCD_WIDTH + area->x1;
+    stride = LCD_WIDTH;
+  }
 
+  stall_watch_flush_begin();
+  uint32_t t0 = micros();
+  perf_governor_spi_begin();
+  lcd.setWindow(area->x1, area->y1, w, h);
+  if (stride != w) {
+    lcd.pushRect(px, w, h, stride);
+  } else {
+    lcd.pushPixels(px, w * h);
+  }
+  // Brightness steps go out between pixel bursts, never in the middle
+  brightness_engine_service(true);
+  perf_governor_spi_end();
+  uint32_t push_us = micros() - t0;
+  uint32_t bytes =
+      w * h * lv_color_format_get_size(lv_display_get_color_format(disp));
+  display_gate_count_flush(bytes);
+  benchmark_count_flush(bytes, push_us);
+
+  // Remote screen capture (no-op unless enabled with "capture on")
+  fb_capture_area(area, px, stride, push_us);
+
+  stall_watch_flush_end();
   lv_display_flush_ready(disp);
 }
 
 void setup() {
+  Serial.setRxBufferSize(OTA_RX_BUFFER_SIZE); // Room for a whole OTA frame
   Serial.begin(115200);
   delay(2000); // Wait for Serial Monitor to connect
   Serial.println("Starting...");
@@ -56,6 +95,9 @@ void setup() {
   // Init I2C for trackball
   Wire.begin(I2C_SDA, I2C_SCL);
 
+  // Restore LED colour, focus, brightness and timeout before anything draws
+  settings_begin();
+
   // Init Display
   if (!lcd.begin()) {
     Serial.println("Display init failed!");
@@ -67,49 +109,70 @@ void setup() {
   if (!trackball.begin(Wire)) {
     Serial.println("Trackball not found!");
   } else {
-    trackball.setRGBW(0, 0, 64, 0); // Start with dim blue
     Serial.println("Trackball ready");
   }
 
   // Init LVGL
   lv_init();
 
+  // LED effects run on an LVGL timer (starts with dim blue)
+  trackball_led_begin(&trackball, saved_led_color());
+
+  // Map the asset pack so fonts/images can be served from flash
+  if (!asset_pack_begin()) {
+    Serial.println("No asset pack, using built-in fonts only");
+  }
+
   // Register tick callback
   lv_tick_set_cb([]() -> uint32_t { return millis(); });
 
   // Create display with LVGL 9 API
   lv_display_t *disp = lv_display_create(LCD_WIDTH, LCD_HEIGHT);
 
-  // Allocate double buffers in PSRAM for smooth rendering
-  size_t buf_size = LCD_WIDTH * BUF_HEIGHT * sizeof(lv_color_t);
-  uint8_t *buf1 = (uint8_t *)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
-  uint8_t *buf2 = (uint8_t *)heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
-
-  if (!buf1 || !buf2) {
-    Serial.println("PSRAM buffer alloc failed, using internal RAM");
-    static uint8_t fallback_buf[LCD_WIDTH * 20 * sizeof(lv_color_t)];
-    lv_display_set_buffers(disp, fallback_buf, NULL, sizeof(fallback_buf),
-                           LV_DISPLAY_RENDER_MODE_PARTIAL);
-  } else {
-    lv_display_set_buffers(disp, buf1, buf2, buf_size,
-                           LV_DISPLAY_RENDER_MODE_PARTIAL);
-    Serial.printf("PSRAM buffers allocated: %d bytes each\n", buf_size);
-  }
+  // Apply the draw buffer strategy stored for this unit (or the default)
+  render_config_begin(disp);
 
   lv_display_set_flush_cb(disp, disp_flush);
 
+  // Rendering pauses while the panel is too dark to see
+  display_gate_begin(disp);
+
+  // Flushed areas can be streamed to a host for remote screen capture
+  fb_capture_begin(disp);
+
+  // Firmware updates over USB into the spare OTA slot ("ota begin ...")
+  ota_update_begin();
+  brightness_engine_begin(settings_get()->brightness);
+
   // Create keypad input device with LVGL 9 API
   lv_indev_t *indev = lv_indev_create();
   lv_indev_set_type(indev, LV_INDEV_TYPE_KEYPAD);
   lv_indev_set_read_cb(indev, keypad_read);
   lv_indev_set_display(indev, disp);
 
-  // Set faster polling rate for better responsiveness
-  lv_timer_set_period(lv_indev_get_read_timer(indev), 20);
+  // Refresh/indev periods and CPU clock follow UI activity (starts at full
+  // speed with 20 ms keypad polling)
+  perf_governor_begin(disp, indev);
+
+  // Battery level caps brightness, idle timeout, refresh and sleep polling
+  battery_governor_begin();
 
   // Build UI
   ui_init();
 
+  // Benchmark buffer strategies on the real UI on first boot, or when the
+  // trackball is held down during boot
+  trackball.update();
+  if (!render_config_is_calibrated() || trackball.isPressed()) {
+    render_config_calibrate(disp);
+  }
+
+  // Render benchmark when selected for this boot ("bench" on the console)
+  benchmark_begin(disp);
+
+  // Heartbeat watchdog for the loop, LVGL timers and flushes
+  stall_watch_begin();
+
   Serial.println("Setup complete");
 }
 
@@ -121,24 +184,49 @@ enum power_state_t {
 };
 
 static power_state_t power_state = STATE_AWAKE;
-static uint8_t cur_brightness = TARGET_BRIGHTNESS;
-static uint32_t last_brightness_update = 0;
 static uint32_t last_activity_time = 0;
 
+// Configured brightness, within the battery's cap
+static uint8_t awake_brightness() {
+  uint8_t cap = battery_governor_limits()->brightness_cap;
+  uint8_t wanted = settings_get()->brightness;
+  return wanted < cap ? wanted : cap;
+}
+
+// Configured idle timeout, shortened on a low battery
+static uint32_t idle_timeout_ms() {
+  uint32_t cap = battery_governor_limits()->idle_timeout_ms;
+  uint32_t wanted = settings_get()->idle_timeout_ms;
+  return wanted < cap ? wanted : cap;
+}
+
+// Fade the panel up to the configured brightness
+static void fade_in() {
+  brightness_engine_fade_to(awake_brightness(), FADE_IN_MS, EASE_OUT_CUBIC);
+}
+
 void enter_light_sleep() {
   Serial.println("Entering light sleep mode...");
 
+  // Don't leave a debounced settings change unwritten while asleep
+  settings_flush();
+
   // Turn off trackball LED completely
-  trackball.setRGBW(0, 0, 0, 0);
+  trackball_led_set_now({{0, 0, 0, 0}});
 
   // Put display in sleep mode
+  STALL_PHASE("lcd sleep");
   lcd.setSleep(true);
 
   // Light sleep with polling: sleep in short bursts and check for activity
   // This is more reliable than GPIO interrupt for I2C devices
+  STALL_PHASE("light sleep");
+  stall_watch_sleep(true);
+  battery_governor_sleep(true);
   while (power_state == STATE_LIGHT_SLEEP) {
-    // Sleep for 100ms at a time
-    esp_sleep_enable_timer_wakeup(100 * 1000ULL); // 100ms in microseconds
+    // Sleep in short bursts (100 ms, longer on a low battery)
+    uint32_t poll_ms = battery_governor_limits()->sleep_poll_ms;
+    esp_sleep_enable_timer_wakeup(poll_ms * 1000ULL);
     esp_light_sleep_start();
 
     // Check for trackball activity after each wake
@@ -151,7 +239,12 @@ void enter_light_sleep() {
 
       Serial.println("Trackball activity detected, waking display!");
 
+      // From here on blocking time counts as a stall again
+      stall_watch_sleep(false);
+      battery_governor_sleep(false);
+
       // Wake display FIRST
+      STALL_PHASE("lcd wake");
       lcd.setSleep(false);
       Serial.println("Display sleep disabled");
 
@@ -159,33 +252,35 @@ void enter_light_sleep() {
       Wire.begin(I2C_SDA, I2C_SCL);
 
       // Reinitialize Serial to restore USB CDC communication
+      STALL_PHASE("serial wake");
       Serial.begin(115200);
       delay(50); // Small delay for USB re-enumeration/sync
 
-      // Restore trackball LED to saved color
-      trackball.setRGBW(saved_led_r, saved_led_g, saved_led_b, saved_led_w);
-      Serial.printf("LED restored: R=%d G=%d B=%d W=%d\n", saved_led_r,
-                    saved_led_g, saved_led_b, saved_led_w);
+      // Restore trackball LED to saved color alongside the display fade-in
+      STALL_PHASE("restore");
+      led_rgbw_t led = saved_led_color();
+      trackball_led_transition(led, FADE_IN_MS);
+      Serial.printf("LED restored: R=%d G=%d B=%d W=%d\n", led.c[LED_R],
+                    led.c[LED_G], led.c[LED_B], led.c[LED_W]);
 
       // Clear any pending trackball data
       trackball.update();
 
       // Set brightness to 0 to start fade-in from black
-      cur_brightness = 0;
-      lcd.setBrightness(cur_brightness);
+      brightness_engine_set(0);
       Serial.println("Brightness reset to 0 for fade-in");
 
-      // Force full screen refresh
+      // Force full screen refresh (rendered once the fade-in lifts the gate)
       lv_obj_invalidate(lv_screen_active());
       Serial.println("Screen invalidated");
 
       // Set activity flag and update timestamp
       g_activity_detected = true;
       last_activity_time = millis();
-      last_brightness_update = millis();
 
       // Change to fading in state
       power_state = STATE_FADING_IN;
+      fade_in();
       Serial.println("State changed to FADING_IN");
 
       break; // Exit sleep loop
@@ -208,11 +303,11 @@ void handle_power_save() {
     if (power_state == STATE_FADING_OUT) {
       Serial.println("Activity during fade-out, reversing...");
       power_state = STATE_FADING_IN;
-      last_brightness_update = now;
+      fade_in();
     } else if (power_state == STATE_LIGHT_SLEEP) {
       // Just came back from light sleep, start fading in
       power_state = STATE_FADING_IN;
-      last_brightness_update = now;
+      fade_in();
     }
   }
 
@@ -220,25 +315,24 @@ void handle_power_save() {
 
   switch (power_state) {
   case STATE_AWAKE:
-    if (idle_time > IDLE_TIMEOUT_MS) {
+    if (idle_time > idle_timeout_ms()) {
       power_state = STATE_FADING_OUT;
-      last_brightness_update = now;
+      brightness_engine_fade_to(0, FADE_OUT_MS, EASE_IN_OUT_CUBIC);
       Serial.println("Idle timeout, fading out...");
+      mem_tiered_report();
+      battery_governor_report();
+      screen_manager_report();
+      trackball_led_report();
+      settings_report();
+      stall_watch_report();
     }
     break;
 
   case STATE_FADING_OUT:
-    if (now - last_brightness_update > FADE_OUT_INTERVAL_MS) {
-      if (cur_brightness > 0) {
-        int next_b = (int)cur_brightness - FADE_OUT_STEP;
-        cur_brightness = (next_b < 0) ? 0 : next_b;
-        lcd.setBrightness(cur_brightness);
-      } else {
-        power_state = STATE_LIGHT_SLEEP;
-        enter_light_sleep(); // Blocks until wake
-        // After wake, state will be changed to FADING_IN by activity detection
-      }
-      last_brightness_update = now;
+    if (!brightness_engine_busy()) {
+      power_state = STATE_LIGHT_SLEEP;
+      enter_light_sleep(); // Blocks until wake
+      // After wake, state will be changed to FADING_IN by activity detection
     }
     break;
 
@@ -247,23 +341,13 @@ void handle_power_save() {
     // Wake-up is handled inside enter_light_sleep()
     Serial.println("WARNING: STATE_LIGHT_SLEEP reached in state machine");
     power_state = STATE_FADING_IN;
+    fade_in();
     break;
 
   case STATE_FADING_IN:
-    if (now - last_brightness_update > FADE_IN_INTERVAL_MS) {
-      if (cur_brightness < TARGET_BRIGHTNESS) {
-        int next_b = (int)cur_brightness + FADE_IN_STEP;
-        cur_brightness =
-            (next_b > TARGET_BRIGHTNESS) ? TARGET_BRIGHTNESS : next_b;
-        lcd.setBrightness(cur_brightness);
-        if (cur_brightness % 48 == 0) {
-          Serial.printf("Fading in... brightness=%d\n", cur_brightness);
-        }
-      } else {
-        power_state = STATE_AWAKE;
-        Serial.println("Display fully awake");
-      }
-      last_brightness_update = now;
+    if (!brightness_engine_busy()) {
+      power_state = STATE_AWAKE;
+      Serial.println("Display fully awake");
     }
     break;
   }
@@ -271,22 +355,62 @@ void handle_power_save() {
 
 // Function to save current LED color (call from ui.cpp button handler)
 void set_trackball_led_color(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
-  saved_led_r = r;
-  saved_led_g = g;
-  saved_led_b = b;
-  saved_led_w = w;
-  trackball.setRGBW(r, g, b, w);
+  settings_set_led(r, g, b, w);
+  trackball_led_transition(saved_led_color(), LED_COLOR_TRANSITION_MS);
 }
 
 void loop() {
+  stall_watch_loop_beat();
+
   // Update trackball ONCE per loop iteration
+  STALL_PHASE("trackball");
   trackball.update();
 
+  // LED writes go right after the read, never in front of the next one
+  trackball_led_service();
+
   // Handle LVGL timers (which will call keypad_read)
+  STALL_PHASE("lvgl");
   lv_timer_handler();
 
+  // Send any brightness step the fade timer produced while nothing flushed
+  brightness_engine_service(false);
+
+  // Pick the performance profile (before power management consumes the flag)
+  perf_governor_update(g_activity_detected, power_state != STATE_AWAKE);
+
+  // Battery sampling and load accounting; re-fade if the cap changed
+  battery_state_t load = perf_governor_profile() == PROFILE_QUIET
+                             ? BATTERY_STATE_QUIET
+                             : BATTERY_STATE_ACTIVE;
+  if (battery_governor_service(load, brightness_engine_level()) &&
+      power_state == STATE_AWAKE) {
+    fade_in();
+  }
+
   // Handle power management
+  STALL_PHASE("power");
   handle_power_save();
 
-  delay(5);
+  // Write settings changes once they have settled
+  STALL_PHASE("settings");
+  settings_service();
+
+  // Host commands (screen capture, firmware update)
+  STALL_PHASE("console");
+  stall_watch_service();
+  serial_console_poll();
+  fb_capture_poll();
+  ota_update_service();
+
+  // Stay awake while an update is streaming in, and poll it more often
+  // (each frame waits for its ACK)
+  if (ota_update_active()) {
+    g_activity_detected = true;
+    delay(1);
+    return;
+  }
+
+  STALL_PHASE("idle");
+  delay(perf_governor_loop_delay_ms());
 }
@@ -0,0 +1,263 @@
+#include "mem_tiered.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#if LV_MEM_TIERED
+#include <multi_heap.h>
+
+// LVGL allocator backend (LV_STDLIB_CUSTOM): two isolated heaps, one in
+// internal RAM for small hot allocations and one carved out of PSRAM for
+// large or cold ones. Each is a multi_heap (TLSF on ESP-IDF 5), so per-tier
+// high-water marks and fragmentation come for free.
+
+enum mem_tier_t { TIER_INTERNAL = 0, TIER_PSRAM = 1, TIER_COUNT = 2 };
+static const char *tier_names[TIER_COUNT] = {"internal", "psram"};
+
+// Size classes by power of two: <=8, <=16, ... <=8192, larger
+#define SIZE_CLASS_COUNT 12
+
+struct size_class_stats_t {
+  uint32_t live;
+  uint32_t peak;
+  uint32_t total;
+};
+
+static multi_heap_handle_t heaps[TIER_COUNT];
+static uint8_t *pool_start[TIER_COUNT];
+static size_t pool_size[TIER_COUNT];
+static bool initialized = false;
+
+static size_class_stats_t classes[SIZE_CLASS_COUNT];
+static uint32_t fallbacks = 0; // Served by the other tier because one was full
+static uint32_t failures = 0;
+
+static uint8_t internal_pool[MEM_INTERNAL_POOL_SIZE] __attribute__((aligned(8)));
+
+static int size_class(size_t size) {
+  int c = 0;
+  size_t limit = 8;
+  while (size > limit && c < SIZE_CLASS_COUNT - 1) {
+    limit <<= 1;
+    c++;
+  }
+  return c;
+}
+
+static int tier_of(const void *p) {
+  for (int t = 0; t < TIER_COUNT; t++) {
+    if (heaps[t] && (const uint8_t *)p >= pool_start[t] &&
+        (const uint8_t *)p < pool_start[t] + pool_size[t])
+      return t;
+  }
+  return -1;
+}
+
+static void track_alloc(int tier, void *p) {
+  size_class_stats_t *c = &classes[size_class(
+      multi_heap_get_allocated_size(heaps[tier], p))];
+  c->live++;
+  c->total++;
+  if (c->live > c->peak)
+    c->peak = c->live;
+}
+
+static void track_free(int tier, void *p) {
+  size_class_stats_t *c = &classes[size_class(
+      multi_heap_get_allocated_size(heaps[tier], p))];
+  if (c->live)
+    c->live--;
+}
+
+static void *tier_malloc(int tier, size_t size) {
+  if (!heaps[tier])
+    return nullptr;
+  void *p = multi_heap_malloc(heaps[tier], size);
+  if (p)
+    track_alloc(tier, p);
+  return p;
+}
+
+static int preferred_tier(size_t size) {
+  return size <= MEM_SMALL_ALLOC_MAX ? TIER_INTERNAL : TIER_PSRAM;
+}
+
+void lv_mem_init(void) {
+  if (initialized)
+    return;
+
+  pool_start[TIER_INTERNAL] = internal_pool;
+  pool_size[TIER_INTERNAL] = sizeof(internal_pool);
+  heaps[TIER_INTERNAL] = multi_heap_register(internal_pool, sizeof(internal_pool));
+
+  pool_start[TIER_PSRAM] =
+      (uint8_t *)heap_caps_malloc(MEM_PSRAM_POOL_SIZE, MALLOC_CAP_SPIRAM);
+  if (pool_start[TIER_PSRAM]) {
+    pool_size[TIER_PSRAM] = MEM_PSRAM_POOL_SIZE;
+    heaps[TIER_PSRAM] =
+        multi_heap_register(pool_start[TIER_PSRAM], MEM_PSRAM_POOL_SIZE);
+  } else {
+    Serial.println("PSRAM LVGL pool alloc failed, using internal pool only");
+  }
+  initialized = true;
+}
+
+void lv_mem_deinit(void) {
+  // Pools live for the lifetime of the firmware
+}
+
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes) {
+  LV_UNUSED(mem);
+  LV_UNUSED(bytes);
+  return NULL;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool) { LV_UNUSED(pool); }
+
+void *lv_malloc_core(size_t size) {
+  if (!initialized)
+    lv_mem_init();
+
+  int pref = preferred_tier(size);
+  void *p = tier_malloc(pref, size);
+  if (!p) {
+    p = tier_malloc(TIER_COUNT - 1 - pref, size);
+    if (p)
+      fallbacks++;
+    else
+      failures++;
+  }
+  return p;
+}
+
+void lv_free_core(void *p) {
+  int t = tier_of(p);
+  if (t < 0)
+    return;
+  track_free(t, p);
+  multi_heap_free(heaps[t], p);
+}
+
+void *lv_realloc_core(void *p, size_t new_size) {
+  if (!p)
+    return lv_malloc_core(new_size);
+  int t = tier_of(p);
+  if (t < 0)
+    return nullptr;
+
+  if (t == preferred_tier(new_size)) {
+    track_free(t, p);
+    void *np = multi_heap_realloc(heaps[t], p, new_size);
+    if (np) {
+      track_alloc(t, np);
+      return np;
+    }
+    track_alloc(t, p); // Original block is untouched on failure
+  }
+
+  // Crossed the size threshold (or the tier is full): move the block
+  void *np = lv_malloc_core(new_size);
+  if (!np)
+    return nullptr;
+  size_t old_size = multi_heap_get_allocated_size(heaps[t], p);
+  memcpy(np, p, old_size < new_size ? old_size : new_size);
+  lv_free_core(p);
+  return np;
+}
+
+// Both tiers merged; see mem_tiered_internal_used_pct() for the internal one
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p) {
+  memset(mon_p, 0, sizeof(*mon_p));
+  size_t min_free = 0;
+  for (int t = 0; t < TIER_COUNT; t++) {
+    if (!heaps[t])
+      continue;
+    multi_heap_info_t info;
+    multi_heap_get_info(heaps[t], &info);
+    mon_p->total_size += pool_size[t];
+    mon_p->free_size += info.total_free_bytes;
+    mon_p->free_cnt += info.free_blocks;
+    mon_p->used_cnt += info.allocated_blocks;
+    if (info.largest_free_block > mon_p->free_biggest_size)
+      mon_p->free_biggest_size = info.largest_free_block;
+    min_free += info.minimum_free_bytes;
+  }
+  if (mon_p->total_size) {
+    mon_p->max_used = mon_p->total_size - min_free;
+    mon_p->used_pct = 100 - (100U * mon_p->free_size) / mon_p->total_size;
+  }
+  if (mon_p->free_size) {
+    mon_p->frag_pct =
+        100 - (100U * mon_p->free_biggest_size) / mon_p->free_size;
+  }
+}
+
+lv_result_t lv_mem_test_core(void) {
+  for (int t = 0; t < TIER_COUNT; t++) {
+    if (heaps[t] && !multi_heap_check(heaps[t], true))
+      return LV_RESULT_INVALID;
+  }
+  return LV_RESULT_OK;
+}
+#endif // LV_MEM_TIERED
+
+uint8_t mem_tiered_internal_used_pct() {
+#if LV_MEM_TIERED
+  if (heaps[TIER_INTERNAL]) {
+    multi_heap_info_t info;
+    multi_heap_get_info(heaps[TIER_INTERNAL], &info);
+    return 100 - (100U * info.total_free_bytes) / pool_size[TIER_INTERNAL];
+  }
+#endif
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  return mon.used_pct;
+}
+
+void mem_tiered_report() {
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  Serial.printf("LVGL heap: %lu/%lu bytes used (%d%%), peak %lu, frag %d%%\n",
+                (unsigned long)(mon.total_size - mon.free_size),
+                (unsigned long)mon.total_size, mon.used_pct,
+                (unsigned long)mon.max_used, mon.frag_pct);
+
+#if LV_MEM_TIERED
+  for (int t = 0; t < TIER_COUNT; t++) {
+    if (!heaps[t])
+      continue;
+    multi_heap_info_t info;
+    multi_heap_get_info(heaps[t], &info);
+    unsigned frag = info.total_free_bytes
+                        ? 100 - (100U * info.largest_free_block) /
+                                    info.total_free_bytes
+                        : 0;
+    Serial.printf("  %-8s: used %u (%u%%), peak %u, free %u, largest %u, "
+                  "frag %u%%\n",
+                  tier_names[t], info.total_allocated_bytes,
+                  100 - (100U * info.total_free_bytes) / pool_size[t],
+                  pool_size[t] - info.minimum_free_bytes,
+                  info.total_free_bytes, info.largest_free_block, frag);
+  }
+  Serial.printf("  tier fallbacks %lu, failures %lu\n",
+                (unsigned long)fallbacks, (unsigned long)failures);
+
+  size_t limit = 8;
+  for (int c = 0; c < SIZE_CLASS_COUNT; c++, limit <<= 1) {
+    if (!classes[c].total)
+      continue;
+    if (c == SIZE_CLASS_COUNT - 1) {
+      Serial.printf("  >%5u B: ", limit >> 1);
+    } else {
+      Serial.printf("  <=%4u B: ", limit);
+    }
+    Serial.printf("live %lu, peak %lu, total %lu\n",
+                  (unsigned long)classes[c].live,
+                  (unsigned long)classes[c].peak,
+                  (unsigned long)classes[c].total);
+  }
+#endif
+
+  Serial.printf("System internal RAM: free %u, low-water %u\n",
+                heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Tier pool sizes (only used when LV_MEM_TIERED is enabled in lv_conf.h)
+#define MEM_INTERNAL_POOL_SIZE (48 * 1024U) // Small, hot allocations
+#define MEM_PSRAM_POOL_SIZE (2 * 1024 * 1024U) // Large or cold allocations
+
+// Allocations up to this size go to the internal-RAM pool
+#define MEM_SMALL_ALLOC_MAX 256
+
+/**
+ * Print LVGL heap usage: per-tier use, high-water marks, fragmentation,
+ * per-size-class counts and the system's internal-RAM low-water mark
+ * Works with either allocator so both setups can be compared
+ */
+void mem_tiered_report();
+
+/**
+ * Percentage of the internal-RAM tier in use (the whole heap with the
+ * builtin allocator). lv_mem_monitor() merges both tiers, and the 2 MB
+ * PSRAM tier hides a nearly full internal one, so check memory pressure
+ * with this instead.
+ */
+uint8_t mem_tiered_internal_used_pct();
@@ -0,0 +1,139 @@
+#include "ota_lz.h"
+#include <string.h>
+
+#define WINDOW_MASK (OTA_LZ_WINDOW - 1)
+
+enum {
+  ST_TOKEN,
+  ST_LIT_EXT,
+  ST_LITERALS,
+  ST_OFFSET_LO,
+  ST_OFFSET_HI,
+  ST_MATCH_EXT,
+  ST_MATCH,
+  ST_DONE,
+};
+
+void lz_decoder_init(lz_decoder_t *dec, uint32_t output_size) {
+  memset(dec, 0, sizeof(*dec));
+  dec->remaining = output_size;
+  dec->state = output_size ? ST_TOKEN : ST_DONE;
+}
+
+static void put(lz_decoder_t *dec, uint8_t b, uint8_t *out, size_t *n) {
+  dec->window[dec->produced & WINDOW_MASK] = b;
+  dec->produced++;
+  dec->remaining--;
+  out[(*n)++] = b;
+}
+
+// Literals done: either the stream ends here or a match follows
+static void after_literals(lz_decoder_t *dec) {
+  dec->state = dec->remaining ? ST_OFFSET_LO : ST_DONE;
+}
+
+static void after_match(lz_decoder_t *dec) {
+  dec->state = dec->remaining ? ST_TOKEN : ST_DONE;
+}
+
+size_t lz_decode(lz_decoder_t *dec, const uint8_t *in, size_t in_len,
+                 size_t *consumed, uint8_t *out, size_t out_cap) {
+  size_t ip = 0, n = 0;
+
+  while (!dec->error && dec->state != ST_DONE) {
+    switch (dec->state) {
+    case ST_TOKEN:
+      if (ip == in_len)
+        goto out;
+      dec->token = in[ip++];
+      dec->lit_len = dec->token >> 4;
+      dec->match_len = (dec->token & 0x0F) + OTA_LZ_MIN_MATCH;
+      if (dec->lit_len == 15)
+        dec->state = ST_LIT_EXT;
+      else if (dec->lit_len)
+        dec->state = ST_LITERALS;
+      else
+        after_literals(dec);
+      break;
+
+    case ST_LIT_EXT: {
+      if (ip == in_len)
+        goto out;
+      uint8_t b = in[ip++];
+      dec->lit_len += b;
+      if (b != 255)
+        dec->state = ST_LITERALS;
+      break;
+    }
+
+    case ST_LITERALS:
+      if (dec->lit_len > dec->remaining) {
+        dec->error = true;
+        break;
+      }
+      while (dec->lit_len && ip < in_len && n < out_cap) {
+        put(dec, in[ip++], out, &n);
+        dec->lit_len--;
+      }
+      if (dec->lit_len)
+        goto out; // Need more input or output space
+      after_literals(dec);
+      break;
+
+    case ST_OFFSET_LO:
+      if (ip == in_len)
+        goto out;
+      dec->offset = in[ip++];
+      dec->state = ST_OFFSET_HI;
+      break;
+
+    case ST_OFFSET_HI:
+      if (ip == in_len)
+        goto out;
+      dec->offset |= (uint16_t)in[ip++] << 8;
+      if (dec->offset == 0 || dec->offset > OTA_LZ_WINDOW ||
+          dec->offset > dec->produced) {
+        dec->error = true;
+        break;
+      }
+      dec->state = (dec->token & 0x0F) == 15 ? ST_MATCH_EXT : ST_MATCH;
+      break;
+
+    case ST_MATCH_EXT: {
+      if (ip == in_len)
+        goto out;
+      uint8_t b = in[ip++];
+      dec->match_len += b;
+      if (b != 255)
+        dec->state = ST_MATCH;
+      break;
+    }
+
+    case ST_MATCH:
+      if (dec->match_len > dec->remaining) {
+        dec->error = true;
+        break;
+      }
+      // Byte by byte: matches may overlap their own output
+      while (dec->match_len && n < out_cap) {
+        put(dec, dec->window[(dec->produced - dec->offset) & WINDOW_MASK], out,
+            &n);
+        dec->match_len--;
+      }
+      if (dec->match_len)
+        goto out;
+      after_match(dec);
+      break;
+    }
+  }
+
+out:
+  *consumed = ip;
+  return n;
+}
+
+bool lz_decoder_done(const lz_decoder_t *dec) {
+  return dec->state == ST_DONE && !dec->error;
+}
+
+bool lz_decoder_error(const lz_decoder_t *dec) { return dec->error; }
@@ -0,0 +1,56 @@
+#pragma once
+
+// Streaming decompressor for firmware images sent by tools/ota_send.py.
+// Plain C++ with no Arduino dependencies so it can be tested on a host.
+//
+// LZ77 with byte-aligned sequences (LZ4-like):
+//   token      high nibble: literal count, low nibble: match length - 4
+//              (a nibble of 15 continues in extension bytes, each added
+//              until one is below 255)
+//   literals   literal count bytes
+//   offset     u16 LE, 1..OTA_LZ_WINDOW back into the output
+// The last sequence ends after its literals; the decoder knows the output
+// size in advance and stops there.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// History kept for back-references (power of two)
+#define OTA_LZ_WINDOW 8192
+#define OTA_LZ_MIN_MATCH 4
+
+struct lz_decoder_t {
+  uint8_t window[OTA_LZ_WINDOW];
+  uint32_t produced;  // Total bytes output so far
+  uint32_t remaining; // Bytes still expected
+  uint8_t state;
+  uint8_t token;
+  uint32_t lit_len;
+  uint32_t match_len;
+  uint16_t offset;
+  bool error;
+};
+
+/**
+ * Prepare to decode a stream that expands to output_size bytes
+ */
+void lz_decoder_init(lz_decoder_t *dec, uint32_t output_size);
+
+/**
+ * Decode as much as fits: stops when input runs out, out is full or the
+ * stream is complete. *consumed is set to the input bytes used.
+ * Returns the bytes written to out. Can be resumed with more input at
+ * any byte boundary.
+ */
+size_t lz_decode(lz_decoder_t *dec, const uint8_t *in, size_t in_len,
+                 size_t *consumed, uint8_t *out, size_t out_cap);
+
+/**
+ * True once output_size bytes have been produced
+ */
+bool lz_decoder_done(const lz_decoder_t *dec);
+
+/**
+ * True if the stream was malformed (bad offset or overlong sequence)
+ */
+bool lz_decoder_error(const lz_decoder_t *dec);
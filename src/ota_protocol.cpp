@@ -0,0 +1,77 @@
+#include "ota_protocol.h"
+#include <string.h>
+
+#define HEADER_SIZE 7
+
+void ota_parser_init(ota_parser_t *parser) { parser->pos = 0; }
+
+uint16_t ota_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+ota_parse_result_t ota_parser_feed(ota_parser_t *parser, const uint8_t *data,
+                                   size_t len, size_t *consumed) {
+  size_t i = 0;
+  ota_frame_t *f = &parser->frame;
+
+  while (i < len) {
+    uint8_t b = data[i++];
+    uint32_t pos = parser->pos;
+
+    // Hunt for the magic, skipping any stray bytes
+    if (pos == 0) {
+      if (b == OTA_MAGIC0)
+        parser->header[parser->pos++] = b;
+      continue;
+    }
+    if (pos == 1) {
+      if (b == OTA_MAGIC1)
+        parser->header[parser->pos++] = b;
+      else
+        parser->pos = (b == OTA_MAGIC0) ? 1 : 0;
+      continue;
+    }
+
+    if (pos < HEADER_SIZE) {
+      parser->header[parser->pos++] = b;
+      if (parser->pos == HEADER_SIZE) {
+        f->type = parser->header[2];
+        f->seq = parser->header[3] | (parser->header[4] << 8);
+        f->len = parser->header[5] | (parser->header[6] << 8);
+        if (f->len > OTA_FRAME_MAX_PAYLOAD) {
+          parser->pos = 0;
+          *consumed = i;
+          return OTA_PARSE_BAD;
+        }
+      }
+      continue;
+    }
+
+    if (pos < HEADER_SIZE + (uint32_t)f->len) {
+      f->payload[pos - HEADER_SIZE] = b;
+      parser->pos++;
+      continue;
+    }
+
+    parser->crc[pos - HEADER_SIZE - f->len] = b;
+    parser->pos++;
+    if (parser->pos < HEADER_SIZE + f->len + 2u)
+      continue;
+
+    // Frame complete
+    parser->pos = 0;
+    *consumed = i;
+    uint16_t crc = ota_crc16(parser->header + 2, HEADER_SIZE - 2, 0xFFFF);
+    crc = ota_crc16(f->payload, f->len, crc);
+    uint16_t sent = parser->crc[0] | (parser->crc[1] << 8);
+    return crc == sent ? OTA_PARSE_FRAME : OTA_PARSE_BAD;
+  }
+
+  *consumed = i;
+  return OTA_PARSE_MORE;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Framing for firmware updates over USB CDC (see ota_update.cpp and
+// tools/ota_send.py). Plain C++ with no Arduino dependencies so it can be
+// tested on a host.
+//
+// Frame: 'O' 'U' <type u8> <seq u16 LE> <len u16 LE> <payload> <crc u16 LE>
+// crc is CRC-16/CCITT-FALSE over type..payload. The sender waits for
+// "OTA ACK <seq>" before sending the next frame and resends on
+// "OTA NAK <seq>" or a timeout.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_MAGIC0 'O'
+#define OTA_MAGIC1 'U'
+#define OTA_FRAME_MAX_PAYLOAD 1024
+
+enum ota_frame_type_t {
+  OTA_FRAME_DATA = 1,  // Next chunk of the compressed image
+  OTA_FRAME_END = 2,   // All data sent; verify and switch slots
+  OTA_FRAME_ABORT = 3, // Give up and discard the partial image
+};
+
+enum ota_parse_result_t {
+  OTA_PARSE_MORE,  // Need more bytes
+  OTA_PARSE_FRAME, // frame holds a complete, valid frame
+  OTA_PARSE_BAD,   // A frame failed its CRC or length check
+};
+
+struct ota_frame_t {
+  uint8_t type;
+  uint16_t seq;
+  uint16_t len;
+  uint8_t payload[OTA_FRAME_MAX_PAYLOAD];
+};
+
+struct ota_parser_t {
+  uint8_t header[7]; // Magic, type, seq, len
+  uint32_t pos;      // Bytes of the current frame received
+  uint8_t crc[2];
+  ota_frame_t frame;
+};
+
+void ota_parser_init(ota_parser_t *parser);
+
+/**
+ * Feed bytes; stops after a frame completes (or fails) so the caller can
+ * act on it before feeding the rest. *consumed is the bytes used.
+ */
+ota_parse_result_t ota_parser_feed(ota_parser_t *parser, const uint8_t *data,
+                                   size_t len, size_t *consumed);
+
+uint16_t ota_crc16(const uint8_t *data, size_t len, uint16_t crc);
@@ -0,0 +1,282 @@
+#include "ota_update.h"
+#include "ota_lz.h"
+#include "ota_protocol.h"
+#include "serial_console.h"
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <string.h>
+
+static bool active = false;
+static bool finishing = false; // END received, draining the decoder
+static esp_ota_handle_t handle = 0;
+static const esp_partition_t *part = nullptr;
+
+// Heap-allocated for the duration of an update only
+static lz_decoder_t *dec = nullptr;
+static ota_parser_t *parser = nullptr;
+static uint8_t *sector = nullptr;
+static uint32_t sector_len = 0;
+
+static mbedtls_sha256_context sha;
+static uint8_t expected_sha[32];
+static uint32_t image_size = 0;
+static uint32_t compressed_size = 0;
+static uint32_t received = 0; // Compressed bytes accepted
+static uint32_t written = 0;  // Image bytes in flash
+
+static uint16_t next_seq = 0;
+static bool frame_pending = false; // parser->frame not fully decoded yet
+static uint32_t frame_pos = 0;
+static uint32_t start_ms = 0;
+static uint32_t last_rx_ms = 0;
+
+static void cleanup() {
+  free(dec);
+  free(parser);
+  free(sector);
+  dec = nullptr;
+  parser = nullptr;
+  sector = nullptr;
+  mbedtls_sha256_free(&sha);
+  active = false;
+  finishing = false;
+  handle = 0;
+  serial_console_hold(false);
+}
+
+static void fail(const char *why) {
+  Serial.printf("OTA FAIL %s\n", why);
+  if (handle)
+    esp_ota_abort(handle);
+  cleanup();
+}
+
+static bool parse_hex(const char *hex, uint8_t *out, size_t len) {
+  if (strlen(hex) != len * 2)
+    return false;
+  for (size_t i = 0; i < len; i++) {
+    char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+    char *end;
+    out[i] = (uint8_t)strtoul(byte, &end, 16);
+    if (*end)
+      return false;
+  }
+  return true;
+}
+
+static void start(uint32_t zsize, uint32_t size, const char *sha_hex) {
+  if (active) {
+    Serial.println("OTA FAIL already running");
+    return;
+  }
+  if (!parse_hex(sha_hex, expected_sha, sizeof(expected_sha))) {
+    Serial.println("OTA FAIL bad sha256");
+    return;
+  }
+
+  part = esp_ota_get_next_update_partition(NULL);
+  if (!part || size > part->size) {
+    Serial.println("OTA FAIL no slot large enough");
+    return;
+  }
+
+  dec = (lz_decoder_t *)malloc(sizeof(lz_decoder_t));
+  parser = (ota_parser_t *)malloc(sizeof(ota_parser_t));
+  sector = (uint8_t *)malloc(OTA_SECTOR_SIZE);
+  mbedtls_sha256_init(&sha);
+  if (!dec || !parser || !sector) {
+    fail("out of memory");
+    return;
+  }
+
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+  // Erase each sector just before writing it instead of the whole slot
+  // up front, which would block the UI for seconds
+  esp_err_t err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+#else
+  esp_err_t err = esp_ota_begin(part, size, &handle);
+#endif
+  if (err != ESP_OK) {
+    handle = 0;
+    fail("esp_ota_begin");
+    return;
+  }
+
+  lz_decoder_init(dec, size);
+  ota_parser_init(parser);
+  mbedtls_sha256_starts(&sha, 0);
+  image_size = size;
+  compressed_size = zsize;
+  received = 0;
+  written = 0;
+  sector_len = 0;
+  next_seq = 0;
+  frame_pending = false;
+  start_ms = last_rx_ms = millis();
+  active = true;
+
+  // From here on the stream carries binary frames
+  serial_console_hold(true);
+  Serial.printf("OTA READY %s %lu\n", part->label, (unsigned long)size);
+}
+
+static void ota_command(const char *args) {
+  unsigned long zsize, size;
+  char sha_hex[72];
+  if (sscanf(args, "begin %lu %lu %70s", &zsize, &size, sha_hex) == 3) {
+    start(zsize, size, sha_hex);
+  } else {
+    Serial.println("usage: ota begin <compressed size> <size> <sha256>");
+  }
+}
+
+void ota_update_begin() { serial_console_register("ota", ota_command); }
+
+bool ota_update_active() { return active; }
+
+static bool write_sector() {
+  if (esp_ota_write(handle, sector, sector_len) != ESP_OK) {
+    fail("flash write");
+    return false;
+  }
+  written += sector_len;
+  sector_len = 0;
+  if (written % (64 * 1024) == 0)
+    Serial.printf("OTA: %lu/%lu\n", (unsigned long)written,
+                  (unsigned long)image_size);
+  return true;
+}
+
+static void finish(uint16_t seq) {
+  if (sector_len && !write_sector())
+    return;
+
+  uint8_t digest[32];
+  mbedtls_sha256_finish(&sha, digest);
+  if (received != compressed_size || written != image_size) {
+    fail("size mismatch");
+    return;
+  }
+  if (memcmp(digest, expected_sha, 32) != 0) {
+    fail("sha256 mismatch");
+    return;
+  }
+  // esp_ota_end also checks the image header and its own checksum
+  esp_err_t err = esp_ota_end(handle);
+  handle = 0;
+  if (err != ESP_OK) {
+    fail("image invalid");
+    return;
+  }
+  if (esp_ota_set_boot_partition(part) != ESP_OK) {
+    fail("set boot partition");
+    return;
+  }
+
+  Serial.printf("OTA OK %lu -> %lu bytes in %lu ms, booting %s\n",
+                (unsigned long)received, (unsigned long)image_size,
+                millis() - start_ms, part->label);
+  Serial.printf("OTA ACK %u\n", seq);
+  cleanup();
+  Serial.flush();
+  delay(200);
+  ESP.restart();
+}
+
+static void handle_frame(const ota_frame_t *f) {
+  last_rx_ms = millis();
+
+  switch (f->type) {
+  case OTA_FRAME_DATA:
+    if (f->seq == next_seq) {
+      received += f->len;
+      frame_pending = true;
+      frame_pos = 0;
+      next_seq++; // Acked once the payload has been decoded
+    } else if (f->seq == (uint16_t)(next_seq - 1)) {
+      Serial.printf("OTA ACK %u\n", f->seq); // Our ACK was lost
+    } else {
+      Serial.printf("OTA NAK %u\n", next_seq);
+    }
+    break;
+  case OTA_FRAME_END:
+    if (f->seq == next_seq) {
+      finishing = true;
+    } else {
+      Serial.printf("OTA NAK %u\n", next_seq);
+    }
+    break;
+  case OTA_FRAME_ABORT:
+    fail("aborted by sender");
+    break;
+  default:
+    Serial.printf("OTA NAK %u\n", next_seq);
+    break;
+  }
+}
+
+void ota_update_service() {
+  if (!active)
+    return;
+  if (millis() - last_rx_ms > OTA_TIMEOUT_MS) {
+    fail("timeout");
+    return;
+  }
+
+  // One flash sector per loop pass keeps LVGL and input running
+  if (sector_len == OTA_SECTOR_SIZE) {
+    write_sector();
+    return;
+  }
+
+  // Decode the pending frame into the sector buffer (with no input this
+  // still finishes a match that didn't fit last time)
+  const ota_frame_t *f = &parser->frame;
+  const uint8_t *in = frame_pending ? f->payload + frame_pos : nullptr;
+  size_t in_len = frame_pending ? f->len - frame_pos : 0;
+  size_t used = 0, produced = 0;
+  if (!lz_decoder_done(dec)) {
+    produced = lz_decode(dec, in, in_len, &used, sector + sector_len,
+                         OTA_SECTOR_SIZE - sector_len);
+    mbedtls_sha256_update(&sha, sector + sector_len, produced);
+    sector_len += produced;
+    frame_pos += used;
+  }
+  if (lz_decoder_error(dec)) {
+    fail("corrupt stream");
+    return;
+  }
+  if (frame_pending && frame_pos == f->len) {
+    frame_pending = false;
+    Serial.printf("OTA ACK %u\n", (uint16_t)(next_seq - 1));
+  } else if (frame_pending && lz_decoder_done(dec)) {
+    fail("data past end of image");
+    return;
+  }
+  if (sector_len == OTA_SECTOR_SIZE || frame_pending)
+    return;
+
+  if (finishing) {
+    if (lz_decoder_done(dec))
+      finish(f->seq);
+    else if (produced == 0)
+      fail("image truncated");
+    return;
+  }
+
+  // Next frame (byte-wise so nothing past its end is taken off Serial)
+  while (Serial.available() > 0) {
+    uint8_t b = Serial.read();
+    size_t n;
+    ota_parse_result_t res = ota_parser_feed(parser, &b, 1, &n);
+    if (res == OTA_PARSE_FRAME) {
+      handle_frame(&parser->frame);
+      break;
+    }
+    if (res == OTA_PARSE_BAD) {
+      Serial.printf("OTA NAK %u\n", next_seq);
+      break;
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Flash is written in whole erase sectors
+#define OTA_SECTOR_SIZE 4096
+
+// Abort if the sender goes quiet for this long
+#define OTA_TIMEOUT_MS 10000
+
+// Serial RX buffer needed to hold a whole frame (set before Serial.begin)
+#define OTA_RX_BUFFER_SIZE 2048
+
+/**
+ * Register the "ota" console command
+ * ("ota begin <compressed size> <image size> <sha256 hex>")
+ */
+void ota_update_begin();
+
+/**
+ * Receive, decompress and write the next piece of an update; at most one
+ * flash sector is written per call so the UI keeps running (call every
+ * loop pass)
+ */
+void ota_update_service();
+
+/**
+ * True while an update is being received
+ */
+bool ota_update_active();
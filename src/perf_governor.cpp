@@ -0,0 +1,129 @@
+#include "perf_governor.h"
+#include <Arduino.h>
+#include <esp_idf_version.h>
+#include <esp_pm.h>
+
+struct profile_params_t {
+  uint32_t refr_period_ms;  // LVGL display refresh timer
+  uint32_t indev_period_ms; // LVGL keypad read timer
+  uint32_t loop_delay_ms;   // Main loop pacing (trackball I2C polling)
+  bool cpu_max;             // Hold the CPU at full speed
+};
+
+static const profile_params_t profiles[] = {
+    {16, 20, 5, true},    // PROFILE_PERFORMANCE
+    {50, 50, 20, false},  // PROFILE_QUIET
+};
+
+static governor_policy_t policy;
+static uint32_t refr_floor_ms = 0; // Battery limit on the refresh rate
+static lv_display_t *gov_disp = nullptr;
+static lv_indev_t *gov_indev = nullptr;
+
+// DFS state: without CONFIG_PM_ENABLE we fall back to fixed clock changes
+static bool dfs_enabled = false;
+static esp_pm_lock_handle_t cpu_lock = nullptr; // Held in PERFORMANCE
+static bool cpu_locked = false; // The lock is recursive, hold it once at most
+static esp_pm_lock_handle_t spi_lock = nullptr; // Held around pixel bursts
+
+// Profile period, slowed to the battery floor
+static uint32_t apply_refresh_period(perf_profile_t profile) {
+  uint32_t refr_ms = profiles[profile].refr_period_ms;
+  if (refr_ms < refr_floor_ms)
+    refr_ms = refr_floor_ms;
+  if (gov_disp)
+    lv_timer_set_period(lv_display_get_refr_timer(gov_disp), refr_ms);
+  return refr_ms;
+}
+
+static void apply_profile(perf_profile_t profile) {
+  const profile_params_t *p = &profiles[profile];
+
+  uint32_t refr_ms = apply_refresh_period(profile);
+  if (gov_indev)
+    lv_timer_set_period(lv_indev_get_read_timer(gov_indev), p->indev_period_ms);
+
+  if (dfs_enabled) {
+    if (p->cpu_max && !cpu_locked && esp_pm_lock_acquire(cpu_lock) == ESP_OK)
+      cpu_locked = true;
+    else if (!p->cpu_max && cpu_locked &&
+             esp_pm_lock_release(cpu_lock) == ESP_OK)
+      cpu_locked = false;
+  } else {
+    setCpuFrequencyMhz(p->cpu_max ? GOVERNOR_CPU_MAX_MHZ : GOVERNOR_CPU_MIN_MHZ);
+  }
+
+  Serial.printf("Governor: %s (refresh %lu ms, indev %lu ms, cpu %s)\n",
+                governor_profile_name(profile), refr_ms,
+                p->indev_period_ms,
+                p->cpu_max ? "240 MHz" : (dfs_enabled ? "DFS" : "80 MHz"));
+}
+
+static void setup_dfs() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t cfg = {};
+#else
+  esp_pm_config_esp32s3_t cfg = {};
+#endif
+  cfg.max_freq_mhz = GOVERNOR_CPU_MAX_MHZ;
+  cfg.min_freq_mhz = GOVERNOR_CPU_MIN_MHZ;
+  cfg.light_sleep_enable = false; // Light sleep is entered explicitly
+
+  esp_err_t err = esp_pm_configure(&cfg);
+  if (err != ESP_OK) {
+    Serial.printf("DFS unavailable (%d), using fixed clock steps\n", err);
+    return;
+  }
+  if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "ui", &cpu_lock) != ESP_OK ||
+      esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "spi", &spi_lock) != ESP_OK) {
+    Serial.println("PM lock create failed, using fixed clock steps");
+    return;
+  }
+  dfs_enabled = true;
+}
+
+void perf_governor_begin(lv_display_t *disp, lv_indev_t *indev) {
+  gov_disp = disp;
+  gov_indev = indev;
+  setup_dfs();
+  governor_policy_init(&policy, millis());
+  apply_profile(policy.profile);
+}
+
+void perf_governor_update(bool input, bool fading) {
+  governor_sample_t sample;
+  sample.now_ms = millis();
+  sample.input = input;
+  sample.animating = lv_anim_count_running() > 0;
+  sample.fading = fading;
+
+  if (governor_policy_step(&policy, &sample)) {
+    apply_profile(policy.profile);
+  }
+}
+
+void perf_governor_set_refresh_floor(uint32_t period_ms) {
+  if (period_ms == refr_floor_ms)
+    return;
+  refr_floor_ms = period_ms;
+  // Only the refresh period depends on the floor; the CPU lock stays as is
+  uint32_t refr_ms = apply_refresh_period(policy.profile);
+  Serial.printf("Governor: refresh %lu ms (battery floor %lu ms)\n",
+                (unsigned long)refr_ms, (unsigned long)period_ms);
+}
+
+perf_profile_t perf_governor_profile() { return policy.profile; }
+
+uint32_t perf_governor_loop_delay_ms() {
+  return profiles[policy.profile].loop_delay_ms;
+}
+
+void perf_governor_spi_begin() {
+  if (dfs_enabled)
+    esp_pm_lock_acquire(spi_lock);
+}
+
+void perf_governor_spi_end() {
+  if (dfs_enabled)
+    esp_pm_lock_release(spi_lock);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "governor_policy.h"
+#include <lvgl.h>
+
+// CPU clock range for dynamic frequency scaling
+#define GOVERNOR_CPU_MAX_MHZ 240
+#define GOVERNOR_CPU_MIN_MHZ 80
+
+/**
+ * Set up DFS and PM locks and apply the performance profile
+ */
+void perf_governor_begin(lv_display_t *disp, lv_indev_t *indev);
+
+/**
+ * Feed this loop pass's activity and switch profiles when the policy says so
+ */
+void perf_governor_update(bool input, bool fading);
+
+/**
+ * Never refresh faster than this, whatever the profile (0: no limit)
+ */
+void perf_governor_set_refresh_floor(uint32_t period_ms);
+
+/**
+ * Profile currently applied
+ */
+perf_profile_t perf_governor_profile();
+
+/**
+ * Main-loop delay for the current profile (also paces trackball polling)
+ */
+uint32_t perf_governor_loop_delay_ms();
+
+/**
+ * Hold the CPU at full speed around an SPI pixel burst (no-op without DFS)
+ */
+void perf_governor_spi_begin();
+void perf_governor_spi_end();
@@ -193,6 +193,24 @@ void QSPI_Display::setWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
   writeCommand(RM67162_RAMWR);
 }
 
+void QSPI_Display::sendChunk(bool first, uint32_t pixels) {
+  if (first) {
+    _spi_tran_ext.base.flags = SPI_TRANS_MODE_QIO;
+    _spi_tran_ext.base.cmd = 0x32;
+    _spi_tran_ext.base.addr = 0x003C00; // RAMWR with dummy
+  } else {
+    _spi_tran_ext.base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD |
+                               SPI_TRANS_VARIABLE_ADDR |
+                               SPI_TRANS_VARIABLE_DUMMY;
+  }
+
+  _spi_tran_ext.base.tx_buffer = _buffer;
+  _spi_tran_ext.base.length = pixels << 4; // bits = pixels * 16
+
+  pollStart();
+  pollEnd();
+}
+
 void QSPI_Display::pushPixels(uint16_t *data, uint32_t len) {
   CS_LOW();
 
@@ -206,26 +224,35 @@ void QSPI_Display::pushPixels(uint16_t *data, uint32_t len) {
 
     // Copy pixel data directly (no byte swap needed with BGR mode)
     memcpy(_buffer, src, chunk * 2);
+    sendChunk(first, chunk);
+    first = false;
 
-    if (first) {
-      _spi_tran_ext.base.flags = SPI_TRANS_MODE_QIO;
-      _spi_tran_ext.base.cmd = 0x32;
-      _spi_tran_ext.base.addr = 0x003C00; // RAMWR with dummy
-      first = false;
-    } else {
-      _spi_tran_ext.base.flags = SPI_TRANS_MODE_QIO | SPI_TRANS_VARIABLE_CMD |
-                                 SPI_TRANS_VARIABLE_ADDR |
-                                 SPI_TRANS_VARIABLE_DUMMY;
-    }
+    src += chunk;
+    remaining -= chunk;
+  }
 
-    _spi_tran_ext.base.tx_buffer = _buffer;
-    _spi_tran_ext.base.length = chunk << 4; // bits = pixels * 16
+  CS_HIGH();
+}
 
-    pollStart();
-    pollEnd();
+void QSPI_Display::pushRect(uint16_t *data, uint32_t w, uint32_t h,
+                            uint32_t stride) {
+  CS_LOW();
 
-    src += chunk;
-    remaining -= chunk;
+  // Gather whole rows into the DMA buffer so each chunk is one transfer
+  uint32_t rows_per_chunk = QSPI_MAX_PIXELS / w;
+  bool first = true;
+  uint32_t row = 0;
+
+  while (row < h) {
+    uint32_t rows = (h - row > rows_per_chunk) ? rows_per_chunk : h - row;
+    uint8_t *dst = _buffer;
+    for (uint32_t r = 0; r < rows; r++) {
+      memcpy(dst, data + (row + r) * stride, w * 2);
+      dst += w * 2;
+    }
+    sendChunk(first, rows * w);
+    first = false;
+    row += rows;
   }
 
   CS_HIGH();
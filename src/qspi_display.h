@@ -37,6 +37,8 @@ public:
 
   void setWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
   void pushPixels(uint16_t *data, uint32_t len);
+  // Push a w x h window out of a larger buffer (stride in pixels)
+  void pushRect(uint16_t *data, uint32_t w, uint32_t h, uint32_t stride);
   void pushColor(uint16_t color, uint32_t len);
 
 private:
@@ -52,6 +54,7 @@ private:
   void CS_LOW();
   void pollStart();
   void pollEnd();
+  void sendChunk(bool first, uint32_t pixels);
 };
 
 // Global instance
@@ -0,0 +1,228 @@
+#include "render_config.h"
+#include "qspi_display.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_heap_caps.h>
+
+#define NVS_NAMESPACE "render"
+#define CONFIG_VERSION 1
+
+// Timed refreshes per candidate and area (after one warm-up refresh)
+#define CALIBRATION_RUNS 4
+
+// Focus moves dominate normal use, so small-area redraws weigh more than
+// full-screen ones in the score
+#define SMALL_AREA_WEIGHT 4
+#define SMALL_AREA_W 180
+#define SMALL_AREA_H 80
+
+// Strategies benchmarked by render_config_calibrate()
+static const render_config_t candidates[] = {
+    {20, true, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {40, true, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {60, true, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {120, true, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {60, true, false, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {10, false, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {20, false, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {30, false, false, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {40, false, false, LV_DISPLAY_RENDER_MODE_PARTIAL, 0},
+    {LCD_HEIGHT, true, false, LV_DISPLAY_RENDER_MODE_FULL, 0},
+    {LCD_HEIGHT, true, true, LV_DISPLAY_RENDER_MODE_FULL, 0},
+    {LCD_HEIGHT, true, true, LV_DISPLAY_RENDER_MODE_DIRECT, 0},
+};
+
+static const render_config_t default_config = {
+    RENDER_DEFAULT_STRIPE, true, true, LV_DISPLAY_RENDER_MODE_PARTIAL, 0};
+
+// Last resort if heap allocation fails. Buffers hold RGB565 pixels
+// (lv_color_t is 3 bytes in LVGL 9, so it can't size them).
+static const render_config_t fallback_config = {
+    20, false, false, LV_DISPLAY_RENDER_MODE_PARTIAL, 0};
+alignas(LV_DRAW_BUF_ALIGN) static uint8_t
+    fallback_buf[LCD_WIDTH * 20 *
+                 LV_COLOR_FORMAT_GET_SIZE(LV_COLOR_FORMAT_RGB565)];
+
+static render_config_t active;
+static uint8_t *bufs[2] = {nullptr, nullptr};
+static bool calibrated = false;
+
+static const char *mode_name(lv_display_render_mode_t mode) {
+  switch (mode) {
+  case LV_DISPLAY_RENDER_MODE_PARTIAL:
+    return "partial";
+  case LV_DISPLAY_RENDER_MODE_DIRECT:
+    return "direct";
+  case LV_DISPLAY_RENDER_MODE_FULL:
+    return "full";
+  default:
+    return "?";
+  }
+}
+
+static void free_buffers() {
+  for (auto &b : bufs) {
+    if (b)
+      heap_caps_free(b);
+    b = nullptr;
+  }
+}
+
+static void apply_fallback(lv_display_t *disp) {
+  free_buffers();
+  lv_display_set_buffers(disp, fallback_buf, NULL, sizeof(fallback_buf),
+                         LV_DISPLAY_RENDER_MODE_PARTIAL);
+  active = fallback_config;
+}
+
+// Free the current buffers first: internal SRAM can't hold both sets
+static bool apply(lv_display_t *disp, const render_config_t *cfg) {
+  free_buffers();
+
+  size_t size = LCD_WIDTH * cfg->stripe_height *
+                lv_color_format_get_size(LV_COLOR_FORMAT_RGB565);
+  uint32_t caps = cfg->psram ? MALLOC_CAP_SPIRAM
+                             : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  for (int i = 0; i < (cfg->double_buffer ? 2 : 1); i++) {
+    bufs[i] = (uint8_t *)heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size, caps);
+    if (!bufs[i]) {
+      apply_fallback(disp);
+      return false;
+    }
+  }
+
+  lv_display_set_buffers(disp, bufs[0], bufs[1], size, cfg->mode);
+  active = *cfg;
+  return true;
+}
+
+static bool load(render_config_t *cfg) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true))
+    return false;
+
+  // A different QSPI clock changes the trade-offs, so recalibrate
+  bool ok = prefs.getUChar("ver", 0) == CONFIG_VERSION &&
+            prefs.getULong("freq", 0) == QSPI_FREQUENCY;
+  if (ok) {
+    cfg->stripe_height = prefs.getUShort("stripe", RENDER_DEFAULT_STRIPE);
+    cfg->psram = prefs.getBool("psram", true);
+    cfg->double_buffer = prefs.getBool("double", true);
+    cfg->mode = (lv_display_render_mode_t)prefs.getUChar(
+        "mode", LV_DISPLAY_RENDER_MODE_PARTIAL);
+    cfg->score_us = prefs.getULong("score", 0);
+    ok = cfg->stripe_height > 0 && cfg->stripe_height <= LCD_HEIGHT;
+  }
+  prefs.end();
+  return ok;
+}
+
+static void save(const render_config_t *cfg) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) {
+    Serial.println("Render config: NVS open failed, not saved");
+    return;
+  }
+  prefs.putUChar("ver", CONFIG_VERSION);
+  prefs.putULong("freq", QSPI_FREQUENCY);
+  prefs.putUShort("stripe", cfg->stripe_height);
+  prefs.putBool("psram", cfg->psram);
+  prefs.putBool("double", cfg->double_buffer);
+  prefs.putUChar("mode", cfg->mode);
+  prefs.putULong("score", cfg->score_us);
+  prefs.end();
+}
+
+void render_config_begin(lv_display_t *disp) {
+  render_config_t cfg;
+  calibrated = load(&cfg);
+  if (!calibrated)
+    cfg = default_config;
+
+  if (!apply(disp, &cfg)) {
+    Serial.println("Render buffer alloc failed, using internal fallback");
+    calibrated = false;
+  }
+  render_config_print();
+}
+
+bool render_config_is_calibrated() { return calibrated; }
+
+// Average time of a synchronous refresh of the given area (whole screen if
+// null), including flushing over QSPI
+static uint32_t time_refresh(lv_display_t *disp, const lv_area_t *area) {
+  lv_obj_t *scr = lv_screen_active();
+  uint32_t total = 0;
+  for (int i = 0; i <= CALIBRATION_RUNS; i++) {
+    if (area) {
+      lv_obj_invalidate_area(scr, area);
+    } else {
+      lv_obj_invalidate(scr);
+    }
+    uint32_t t0 = micros();
+    lv_refr_now(disp);
+    if (i > 0)
+      total += micros() - t0;
+  }
+  return total / CALIBRATION_RUNS;
+}
+
+void render_config_calibrate(lv_display_t *disp) {
+  Serial.println("Calibrating render buffers...");
+
+  lv_area_t small;
+  small.x1 = (LCD_WIDTH - SMALL_AREA_W) / 2;
+  small.y1 = (LCD_HEIGHT - SMALL_AREA_H) / 2;
+  small.x2 = small.x1 + SMALL_AREA_W - 1;
+  small.y2 = small.y1 + SMALL_AREA_H - 1;
+
+  render_config_t best = {};
+  best.score_us = UINT32_MAX;
+  for (const auto &c : candidates) {
+    if (!apply(disp, &c)) {
+      Serial.printf("  %-7s %3u lines %-8s x%d: alloc failed\n",
+                    mode_name(c.mode), c.stripe_height,
+                    c.psram ? "psram" : "internal", c.double_buffer ? 2 : 1);
+      continue;
+    }
+    uint32_t full_us = time_refresh(disp, nullptr);
+    uint32_t small_us = time_refresh(disp, &small);
+    uint32_t score = full_us + SMALL_AREA_WEIGHT * small_us;
+    Serial.printf("  %-7s %3u lines %-8s x%d: full %lu us, small %lu us, "
+                  "score %lu\n",
+                  mode_name(c.mode), c.stripe_height,
+                  c.psram ? "psram" : "internal", c.double_buffer ? 2 : 1,
+                  full_us, small_us, score);
+    if (score < best.score_us) {
+      best = c;
+      best.score_us = score;
+    }
+  }
+
+  if (best.score_us == UINT32_MAX || !apply(disp, &best)) {
+    Serial.println("Render calibration failed, using default");
+    if (!apply(disp, &default_config))
+      Serial.println("Render buffer alloc failed, using internal fallback");
+    calibrated = false;
+    return;
+  }
+
+  active.score_us = best.score_us;
+  calibrated = true;
+  save(&active);
+  lv_obj_invalidate(lv_screen_active());
+  render_config_print();
+}
+
+const render_config_t *render_config_active() { return &active; }
+
+void render_config_print() {
+  uint64_t mac = ESP.getEfuseMac();
+  Serial.printf("RENDER_CONFIG unit=%012llx qspi_hz=%lu mode=%s stripe=%u "
+                "mem=%s buffers=%d score_us=%lu calibrated=%d\n",
+                (unsigned long long)mac, (unsigned long)QSPI_FREQUENCY,
+                mode_name(active.mode), active.stripe_height,
+                active.psram ? "psram" : "internal",
+                active.double_buffer ? 2 : 1, (unsigned long)active.score_us,
+                calibrated ? 1 : 0);
+}
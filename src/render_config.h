@@ -0,0 +1,41 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Default strategy before a unit has been calibrated
+#define RENDER_DEFAULT_STRIPE 60
+
+struct render_config_t {
+  uint16_t stripe_height; // Lines per buffer (LCD_HEIGHT in full/direct mode)
+  bool psram;             // Buffers in PSRAM (else internal SRAM)
+  bool double_buffer;
+  lv_display_render_mode_t mode;
+  uint32_t score_us; // Calibration score (0 = not calibrated)
+};
+
+/**
+ * Load the stored strategy from NVS (or the default) and apply it
+ * Falls back to a small internal buffer if allocation fails
+ */
+void render_config_begin(lv_display_t *disp);
+
+/**
+ * True if the active strategy came from a calibration for this QSPI clock
+ */
+bool render_config_is_calibrated();
+
+/**
+ * Benchmark every candidate strategy on the current screen content, apply
+ * the fastest and store it in NVS. Call after the UI is built.
+ */
+void render_config_calibrate(lv_display_t *disp);
+
+/**
+ * Strategy currently applied to the display
+ */
+const render_config_t *render_config_active();
+
+/**
+ * Print the active strategy in a machine-readable line for unit comparison
+ */
+void render_config_print();
@@ -0,0 +1,296 @@
+#include "screen_manager.h"
+#include "mem_tiered.h"
+#include "serial_console.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+struct screen_page_t {
+  const char *name;
+  screen_build_cb_t build;
+  bool keep_snapshot;
+
+  // Resident state (scr is NULL while released)
+  lv_obj_t *scr;
+  lv_group_t *group;
+  lv_obj_t *focus;
+  uint32_t last_shown_ms;
+
+  // Image of the page taken just before it was released
+  lv_draw_buf_t snap;
+  uint8_t *snap_data;
+  uint32_t snap_size;
+  bool snap_valid;
+
+  // Statistics
+  uint32_t builds;
+  uint32_t last_build_us;
+  int32_t heap_bytes; // LVGL heap taken by the last build
+};
+
+static screen_page_t pages[SCREEN_MAX_PAGES];
+static int page_count = 0;
+static int active_id = -1;
+
+static lv_indev_t *keypad = nullptr;
+static lv_obj_t *boot_screen = nullptr; // Display's default screen
+
+// Snapshot shown while a released page is rebuilt
+static lv_obj_t *placeholder = nullptr;
+static int rebuild_id = -1;
+static bool rebuild_scheduled = false;
+
+static uint32_t heap_used() {
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  return mon.total_size - mon.free_size;
+}
+
+static void build(screen_page_t *p) {
+  uint32_t t0 = micros();
+  uint32_t used0 = heap_used();
+
+  // Buttons join the default group on creation, which would put gridnav
+  // cells in the group next to their container; pages add objects
+  // explicitly instead
+  lv_group_t *prev_default = lv_group_get_default();
+  lv_group_set_default(NULL);
+  p->group = lv_group_create();
+  p->scr = lv_obj_create(NULL);
+  p->focus = p->build(p->scr, p->group);
+  lv_group_set_default(prev_default);
+  lv_obj_update_layout(p->scr);
+
+  p->builds++;
+  p->last_build_us = micros() - t0;
+  p->heap_bytes = (int32_t)(heap_used() - used0);
+  Serial.printf("Screen '%s' built in %lu us, LVGL heap +%ld bytes\n",
+                p->name, (unsigned long)p->last_build_us, (long)p->heap_bytes);
+}
+
+// Render the page into PSRAM so it can be shown while it is rebuilt
+static bool take_snapshot(screen_page_t *p) {
+  uint32_t w = lv_obj_get_width(p->scr);
+  uint32_t h = lv_obj_get_height(p->scr);
+  uint32_t stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565);
+  uint32_t size = stride * h;
+
+  if (size > p->snap_size) {
+    if (p->snap_data)
+      heap_caps_free(p->snap_data);
+    p->snap_data = (uint8_t *)heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size,
+                                                      MALLOC_CAP_SPIRAM);
+    p->snap_size = p->snap_data ? size : 0;
+    if (!p->snap_data) {
+      Serial.println("Screen: snapshot PSRAM alloc failed");
+      return false;
+    }
+  }
+
+  lv_image_cache_drop(&p->snap);
+  if (lv_draw_buf_init(&p->snap, w, h, LV_COLOR_FORMAT_RGB565, stride,
+                       p->snap_data, p->snap_size) != LV_RESULT_OK) {
+    return false;
+  }
+  return lv_snapshot_take_to_draw_buf(p->scr, LV_COLOR_FORMAT_RGB565,
+                                      &p->snap) == LV_RESULT_OK;
+}
+
+static void release(screen_page_t *p) {
+  uint32_t used0 = heap_used();
+  if (p->keep_snapshot)
+    p->snap_valid = take_snapshot(p);
+
+  // Objects leave the group as they are deleted, then the group goes
+  lv_obj_delete(p->scr);
+  lv_group_delete(p->group);
+  p->scr = nullptr;
+  p->group = nullptr;
+  p->focus = nullptr;
+
+  Serial.printf("Screen '%s' released, LVGL heap -%lu bytes%s\n", p->name,
+                (unsigned long)(used0 - heap_used()),
+                p->snap_valid ? " (snapshot kept)" : "");
+}
+
+static int resident_count() {
+  int n = 0;
+  for (int i = 0; i < page_count; i++) {
+    if (pages[i].scr)
+      n++;
+  }
+  return n;
+}
+
+// Least recently shown page that is built but not on screen
+static screen_page_t *lru_idle_page() {
+  screen_page_t *lru = nullptr;
+  for (int i = 0; i < page_count; i++) {
+    screen_page_t *p = &pages[i];
+    if (!p->scr || i == active_id || i == rebuild_id)
+      continue;
+    if (!lru || (int32_t)(p->last_shown_ms - lru->last_shown_ms) < 0)
+      lru = p;
+  }
+  return lru;
+}
+
+static void release_under_pressure() {
+  while (resident_count() > SCREEN_MAX_RESIDENT ||
+         mem_tiered_internal_used_pct() > SCREEN_RELEASE_USED_PCT) {
+    screen_page_t *p = lru_idle_page();
+    if (!p)
+      break;
+    release(p);
+  }
+}
+
+static void load(int id) {
+  screen_page_t *p = &pages[id];
+  lv_screen_load(p->scr);
+  active_id = id;
+  p->last_shown_ms = millis();
+
+  // Keypad (and gridnav containers in the group) now drive this page
+  if (keypad)
+    lv_indev_set_group(keypad, p->group);
+  lv_group_set_default(p->group);
+  if (p->focus)
+    lv_group_focus_obj(p->focus);
+
+  if (placeholder) {
+    lv_obj_delete(placeholder);
+    placeholder = nullptr;
+  }
+  if (boot_screen) {
+    lv_obj_delete(boot_screen);
+    boot_screen = nullptr;
+  }
+  release_under_pressure();
+}
+
+static void rebuild_async(void *) {
+  rebuild_scheduled = false;
+  int id = rebuild_id;
+  rebuild_id = -1;
+  if (id < 0)
+    return;
+  if (!pages[id].scr)
+    build(&pages[id]);
+  load(id);
+}
+
+// The placeholder has been drawn; rebuild on the next LVGL pass
+static void refr_ready_cb(lv_event_t *) {
+  if (rebuild_id >= 0 && !rebuild_scheduled) {
+    rebuild_scheduled = true;
+    lv_async_call(rebuild_async, nullptr);
+  }
+}
+
+static void show_placeholder(screen_page_t *p) {
+  lv_obj_t *scr = lv_obj_create(NULL);
+  lv_obj_remove_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_set_style_pad_all(scr, 0, 0);
+  lv_obj_t *img = lv_image_create(scr);
+  lv_image_set_src(img, &p->snap);
+  lv_obj_set_pos(img, 0, 0);
+
+  lv_screen_load(scr);
+  if (placeholder)
+    lv_obj_delete(placeholder);
+  placeholder = scr;
+
+  // Nothing is focusable until the real page is back
+  if (keypad)
+    lv_indev_set_group(keypad, NULL);
+}
+
+int screen_manager_active() { return active_id; }
+
+void screen_manager_show(int id) {
+  if (id < 0 || id >= page_count)
+    return;
+  if (id == active_id && pages[id].scr && !placeholder)
+    return;
+
+  screen_page_t *p = &pages[id];
+  if (p->scr) {
+    rebuild_id = -1; // A pending rebuild of another page is no longer wanted
+    load(id);
+    return;
+  }
+  if (p->snap_valid) {
+    // Show the image now, build once it has been drawn
+    show_placeholder(p);
+    active_id = id;
+    p->last_shown_ms = millis();
+    rebuild_id = id;
+    return;
+  }
+  rebuild_id = -1;
+  build(p);
+  load(id);
+}
+
+int screen_manager_add(const char *name, screen_build_cb_t build,
+                       bool keep_snapshot) {
+  if (page_count >= SCREEN_MAX_PAGES) {
+    Serial.printf("Screen: no room for '%s'\n", name);
+    return -1;
+  }
+  screen_page_t *p = &pages[page_count];
+  memset(p, 0, sizeof(*p));
+  p->name = name;
+  p->build = build;
+  p->keep_snapshot = keep_snapshot;
+  return page_count++;
+}
+
+int screen_manager_find(const char *name) {
+  for (int i = 0; i < page_count; i++) {
+    if (strcmp(pages[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+void screen_manager_release_idle() {
+  screen_page_t *p;
+  while ((p = lru_idle_page()) != nullptr)
+    release(p);
+}
+
+void screen_manager_report() {
+  Serial.printf("Screens: %d registered, %d resident, LVGL internal heap %u%% "
+                "used\n",
+                page_count, resident_count(), mem_tiered_internal_used_pct());
+  for (int i = 0; i < page_count; i++) {
+    const screen_page_t *p = &pages[i];
+    const char *state = p->scr ? (i == active_id ? "active" : "idle")
+                               : (p->snap_valid ? "snapshot" : "released");
+    Serial.printf("  %-10s %-8s builds %lu, last %lu us, heap %ld bytes\n",
+                  p->name, state, (unsigned long)p->builds,
+                  (unsigned long)p->last_build_us, (long)p->heap_bytes);
+  }
+}
+
+static void screen_command(const char *args) {
+  if (*args == '\0' || strcmp(args, "list") == 0) {
+    screen_manager_report();
+  } else if (strcmp(args, "release") == 0) {
+    screen_manager_release_idle();
+  } else if (screen_manager_find(args) >= 0) {
+    screen_manager_show(screen_manager_find(args));
+  } else {
+    Serial.println("usage: screen list|release|<name>");
+  }
+}
+
+void screen_manager_begin(lv_indev_t *indev) {
+  keypad = indev;
+  boot_screen = lv_screen_active();
+  lv_display_add_event_cb(lv_display_get_default(), refr_ready_cb,
+                          LV_EVENT_REFR_READY, NULL);
+  serial_console_register("screen", screen_command);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Pages that can be registered
+#define SCREEN_MAX_PAGES 8
+
+// Built pages kept resident, including the active one; the least recently
+// shown idle page is released beyond this
+#define SCREEN_MAX_RESIDENT 2
+
+// Idle pages are also released while use of the LVGL heap's internal-RAM
+// tier (where pages' objects and styles live) is above this
+#define SCREEN_RELEASE_USED_PCT 75
+
+/**
+ * Build a page's widgets into `scr` and add its focusable objects (or
+ * gridnav containers) to `group`. There is no default group during the
+ * call, so nothing else is added implicitly.
+ * Returns the object to focus first (NULL: the group's first object).
+ */
+typedef lv_obj_t *(*screen_build_cb_t)(lv_obj_t *scr, lv_group_t *group);
+
+/**
+ * Bind page focus to the keypad input device and register the "screen"
+ * console command ("screen list|release|<name>")
+ */
+void screen_manager_begin(lv_indev_t *indev);
+
+/**
+ * Register a page; nothing is built until it is first shown.
+ * With keep_snapshot the page is rendered into a PSRAM image before it is
+ * released, so returning to it shows that image at once while the real
+ * page is rebuilt on the next LVGL pass.
+ * Returns the page id, or -1 if there is no room.
+ */
+int screen_manager_add(const char *name, screen_build_cb_t build,
+                       bool keep_snapshot);
+
+/**
+ * Page id by name, or -1
+ */
+int screen_manager_find(const char *name);
+
+/**
+ * Id of the page on screen, or -1 before the first is shown
+ */
+int screen_manager_active();
+
+/**
+ * Show a page, building it if needed, and move keypad focus to its group
+ */
+void screen_manager_show(int id);
+
+/**
+ * Release every idle page (e.g. before a heavy operation)
+ */
+void screen_manager_release_idle();
+
+/**
+ * Print each page's state, build time and LVGL heap use
+ */
+void screen_manager_report();
@@ -0,0 +1,66 @@
+#include "serial_console.h"
+#include <Arduino.h>
+#include <string.h>
+
+struct console_command_t {
+  const char *name;
+  console_handler_t handler;
+};
+
+static console_command_t commands[CONSOLE_MAX_COMMANDS];
+static uint8_t command_count = 0;
+
+static char line[CONSOLE_LINE_MAX];
+static uint8_t line_len = 0;
+static bool held = false;
+
+void serial_console_register(const char *command, console_handler_t handler) {
+  if (command_count >= CONSOLE_MAX_COMMANDS) {
+    Serial.printf("Console: no room for '%s'\n", command);
+    return;
+  }
+  commands[command_count].name = command;
+  commands[command_count].handler = handler;
+  command_count++;
+}
+
+static void dispatch() {
+  char *args = strchr(line, ' ');
+  size_t name_len = args ? (size_t)(args - line) : strlen(line);
+  if (args)
+    args++;
+  else
+    args = line + name_len;
+
+  for (uint8_t i = 0; i < command_count; i++) {
+    if (strlen(commands[i].name) == name_len &&
+        strncmp(commands[i].name, line, name_len) == 0) {
+      commands[i].handler(args);
+      return;
+    }
+  }
+  Serial.printf("Console: unknown command '%s'\n", line);
+}
+
+void serial_console_poll() {
+  while (!held && Serial.available() > 0) {
+    int c = Serial.read();
+    if (c == '\r')
+      continue;
+    if (c == '\n') {
+      line[line_len] = '\0';
+      if (line_len > 0)
+        dispatch();
+      line_len = 0;
+      continue;
+    }
+    // Overlong lines are truncated rather than split into two commands
+    if (line_len < CONSOLE_LINE_MAX - 1)
+      line[line_len++] = (char)c;
+  }
+}
+
+void serial_console_hold(bool hold) {
+  held = hold;
+  line_len = 0;
+}
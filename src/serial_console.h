@@ -0,0 +1,24 @@
+#pragma once
+
+// Line-based commands over USB CDC ("<command> [args]\n")
+
+typedef void (*console_handler_t)(const char *args);
+
+#define CONSOLE_MAX_COMMANDS 8
+#define CONSOLE_LINE_MAX 96
+
+/**
+ * Register a handler for lines starting with command
+ */
+void serial_console_register(const char *command, console_handler_t handler);
+
+/**
+ * Read pending input and dispatch complete lines (call every loop pass)
+ */
+void serial_console_poll();
+
+/**
+ * Stop reading Serial so a command can take over the stream for binary
+ * data (e.g. a firmware update); release to resume line handling
+ */
+void serial_console_hold(bool hold);
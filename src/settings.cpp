@@ -0,0 +1,165 @@
+#include "settings.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <string.h>
+
+#define NVS_NAMESPACE "settings"
+#define NVS_KEY "v1"
+
+// Bump when settings_t changes layout; old blobs are then ignored
+#define SETTINGS_VERSION 1
+
+struct settings_blob_t {
+  uint8_t version;
+  settings_t values;
+};
+
+static settings_t current;
+static settings_t stored; // What NVS holds
+static bool dirty = false;
+static uint32_t last_change_ms = 0;
+static uint32_t last_commit_ms = 0;
+static bool suspended = false;
+static settings_t saved; // Values to return to when resumed
+
+// Statistics
+static uint32_t restore_us = 0;
+static uint32_t change_count = 0;
+static uint32_t commit_count = 0;
+static uint32_t commit_us_max = 0;
+
+static void set_defaults(settings_t *s) {
+  memset(s, 0, sizeof(*s));
+  s->led[2] = 64; // Dim blue
+  s->focused_index = 0;
+  s->brightness = SETTINGS_DEFAULT_BRIGHTNESS;
+  s->idle_timeout_ms = SETTINGS_DEFAULT_IDLE_TIMEOUT_MS;
+}
+
+void settings_begin() {
+  uint32_t t0 = micros();
+  settings_blob_t blob;
+  bool ok = false;
+
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, true)) {
+    ok = prefs.getBytes(NVS_KEY, &blob, sizeof(blob)) == sizeof(blob) &&
+         blob.version == SETTINGS_VERSION;
+    prefs.end();
+  }
+
+  if (ok) {
+    current = blob.values;
+  } else {
+    set_defaults(&current);
+  }
+  stored = current;
+  restore_us = micros() - t0;
+  last_commit_ms = millis() - SETTINGS_MIN_COMMIT_INTERVAL_MS;
+
+  Serial.printf("Settings %s in %lu us\n", ok ? "restored" : "defaulted",
+                restore_us);
+}
+
+const settings_t *settings_get() { return &current; }
+
+// Field by field: settings_t has padding, which memcmp would compare too
+static bool same(const settings_t *a, const settings_t *b) {
+  return memcmp(a->led, b->led, sizeof(a->led)) == 0 &&
+         a->focused_index == b->focused_index &&
+         a->brightness == b->brightness &&
+         a->idle_timeout_ms == b->idle_timeout_ms;
+}
+
+static void changed() {
+  change_count++;
+  last_change_ms = millis();
+  dirty = !same(&current, &stored);
+}
+
+void settings_set_led(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+  current.led[0] = r;
+  current.led[1] = g;
+  current.led[2] = b;
+  current.led[3] = w;
+  changed();
+}
+
+void settings_set_focused(uint16_t index) {
+  current.focused_index = index;
+  changed();
+}
+
+void settings_set_brightness(uint8_t brightness) {
+  current.brightness = brightness;
+  changed();
+}
+
+void settings_set_idle_timeout(uint32_t ms) {
+  current.idle_timeout_ms = ms;
+  changed();
+}
+
+static void commit() {
+  uint32_t t0 = micros();
+  settings_blob_t blob;
+  memset(&blob, 0, sizeof(blob));
+  blob.version = SETTINGS_VERSION;
+  blob.values = current;
+
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) {
+    Serial.println("Settings: NVS open failed");
+    return;
+  }
+  // One blob write: NVS appends a new entry and retires the old one, so a
+  // power cut leaves either the previous or the new settings intact
+  prefs.putBytes(NVS_KEY, &blob, sizeof(blob));
+  prefs.end();
+
+  stored = current;
+  dirty = false;
+  last_commit_ms = millis();
+  commit_count++;
+  uint32_t us = micros() - t0;
+  if (us > commit_us_max)
+    commit_us_max = us;
+}
+
+void settings_suspend(bool suspend) {
+  if (suspend == suspended)
+    return;
+  suspended = suspend;
+  if (suspend) {
+    saved = current;
+    return;
+  }
+  current = saved;
+  dirty = !same(&current, &stored);
+}
+
+void settings_service() {
+  if (!dirty || suspended)
+    return;
+  uint32_t now = millis();
+  if (now - last_change_ms < SETTINGS_DEBOUNCE_MS)
+    return;
+  if (now - last_commit_ms < SETTINGS_MIN_COMMIT_INTERVAL_MS)
+    return;
+  commit();
+}
+
+void settings_flush() {
+  if (dirty && !suspended)
+    commit();
+}
+
+void settings_report() {
+  uint32_t uptime_s = millis() / 1000;
+  uint32_t per_hour = uptime_s ? commit_count * 3600UL / uptime_s : 0;
+  Serial.printf("Settings: restore %lu us, %lu changes -> %lu commits "
+                "(~%lu/h, max %lu us)\n",
+                restore_us, (unsigned long)change_count,
+                (unsigned long)commit_count, (unsigned long)per_hour,
+                commit_us_max);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+// Defaults for a fresh unit (or after a layout change)
+#define SETTINGS_DEFAULT_BRIGHTNESS 200
+#define SETTINGS_DEFAULT_IDLE_TIMEOUT_MS 10000
+
+// A change is written once things have been quiet for this long...
+#define SETTINGS_DEBOUNCE_MS 2000
+// ...but never more often than this (bounds flash wear under rapid input)
+#define SETTINGS_MIN_COMMIT_INTERVAL_MS 30000
+
+struct settings_t {
+  uint8_t led[4]; // Trackball R, G, B, W
+  uint16_t focused_index;
+  uint8_t brightness; // Panel brightness when awake
+  uint32_t idle_timeout_ms;
+};
+
+/**
+ * Restore all settings from NVS with a single blob read (defaults if
+ * missing). Call early in setup(), before anything is drawn.
+ */
+void settings_begin();
+
+/**
+ * Current values (RAM copy, always up to date)
+ */
+const settings_t *settings_get();
+
+void settings_set_led(uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+void settings_set_focused(uint16_t index);
+void settings_set_brightness(uint8_t brightness);
+void settings_set_idle_timeout(uint32_t ms);
+
+/**
+ * While suspended, changes are kept in RAM only and are dropped again on
+ * resume (the benchmark drives the real UI, which would otherwise save
+ * its focus moves)
+ */
+void settings_suspend(bool suspend);
+
+/**
+ * Commit pending changes once the debounce and rate limit allow
+ * (call every loop pass)
+ */
+void settings_service();
+
+/**
+ * Commit pending changes now (before sleep)
+ */
+void settings_flush();
+
+/**
+ * Print restore time, change count and commit rate
+ */
+void settings_report();
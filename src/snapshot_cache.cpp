@@ -0,0 +1,374 @@
+#include "snapshot_cache.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// Cached looks per object
+enum snapshot_look_t { LOOK_NORMAL = 0, LOOK_FOCUSED = 1, LOOK_COUNT = 2 };
+
+// States applied while rendering the focused look (gridnav sets both)
+#define FOCUSED_STATES (LV_STATE_FOCUSED | LV_STATE_FOCUS_KEY)
+
+struct snapshot_entry_t {
+  lv_obj_t *obj;
+  lv_obj_t *img; // Sibling image that shows the cached look
+  lv_draw_buf_t buf[LOOK_COUNT];
+  uint8_t *data[LOOK_COUNT];
+  uint32_t data_size[LOOK_COUNT];
+  uint32_t fingerprint[LOOK_COUNT];
+  bool valid;
+  bool check_pending;
+};
+
+static snapshot_entry_t entries[SNAPSHOT_CACHE_MAX_ENTRIES];
+
+// Set while the cache itself changes styles/states so its own events are
+// not mistaken for external style changes
+static bool internal_change = false;
+static bool check_scheduled = false;
+
+// Render timing of the refresh following each focus move
+static bool timing_hooked = false;
+static bool focus_move_pending = false;
+static uint32_t refr_start_us = 0;
+static uint32_t focus_moves = 0;
+static uint64_t focus_render_total_us = 0;
+static uint32_t focus_render_max_us = 0;
+
+enum prop_kind_t { PROP_NUM, PROP_COLOR, PROP_PTR };
+
+// Style properties that affect the cached look
+static const struct {
+  lv_style_prop_t prop;
+  prop_kind_t kind;
+} fingerprint_props[] = {
+    {LV_STYLE_BG_COLOR, PROP_COLOR},      {LV_STYLE_BG_OPA, PROP_NUM},
+    {LV_STYLE_RADIUS, PROP_NUM},          {LV_STYLE_BORDER_WIDTH, PROP_NUM},
+    {LV_STYLE_BORDER_COLOR, PROP_COLOR},  {LV_STYLE_BORDER_OPA, PROP_NUM},
+    {LV_STYLE_OUTLINE_WIDTH, PROP_NUM},   {LV_STYLE_OUTLINE_COLOR, PROP_COLOR},
+    {LV_STYLE_OUTLINE_PAD, PROP_NUM},     {LV_STYLE_SHADOW_WIDTH, PROP_NUM},
+    {LV_STYLE_TEXT_COLOR, PROP_COLOR},    {LV_STYLE_TEXT_FONT, PROP_PTR},
+};
+
+static uint32_t hash_mix(uint32_t h, uint32_t v) {
+  // FNV-1a over the 4 bytes of v
+  for (int i = 0; i < 4; i++) {
+    h ^= (v >> (i * 8)) & 0xFF;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static uint32_t obj_fingerprint(lv_obj_t *obj, uint32_t h) {
+  for (const auto &fp : fingerprint_props) {
+    lv_style_value_t v = lv_obj_get_style_prop(obj, LV_PART_MAIN, fp.prop);
+    switch (fp.kind) {
+    case PROP_NUM:
+      h = hash_mix(h, (uint32_t)v.num);
+      break;
+    case PROP_COLOR:
+      h = hash_mix(h, lv_color_to_u32(v.color));
+      break;
+    case PROP_PTR:
+      h = hash_mix(h, (uint32_t)(uintptr_t)v.ptr);
+      break;
+    }
+  }
+  h = hash_mix(h, (uint32_t)lv_obj_get_width(obj));
+  h = hash_mix(h, (uint32_t)lv_obj_get_height(obj));
+
+  if (lv_obj_check_type(obj, &lv_label_class)) {
+    for (const char *c = lv_label_get_text(obj); c && *c; c++) {
+      h = hash_mix(h, (uint8_t)*c);
+    }
+  }
+  return h;
+}
+
+// Fingerprint of the object and its children in their current state
+static uint32_t entry_fingerprint(snapshot_entry_t *e) {
+  uint32_t h = obj_fingerprint(e->obj, 2166136261u);
+  uint32_t cnt = lv_obj_get_child_count(e->obj);
+  for (uint32_t i = 0; i < cnt; i++) {
+    h = obj_fingerprint(lv_obj_get_child(e->obj, i), h);
+  }
+  return h;
+}
+
+static snapshot_entry_t *find_entry(lv_obj_t *obj) {
+  for (auto &e : entries) {
+    if (e.obj == obj)
+      return &e;
+  }
+  return nullptr;
+}
+
+static void release_buffers(snapshot_entry_t *e) {
+  for (int look = 0; look < LOOK_COUNT; look++) {
+    if (e->data[look]) {
+      lv_image_cache_drop(&e->buf[look]);
+      heap_caps_free(e->data[look]);
+    }
+    e->data[look] = nullptr;
+    e->data_size[look] = 0;
+  }
+  e->valid = false;
+}
+
+// Live: the object draws itself. Cached: the object is transparent and the
+// sibling image shows the pre-rendered look.
+static void set_live(snapshot_entry_t *e, bool live) {
+  if (live) {
+    lv_obj_remove_local_style_prop(e->obj, LV_STYLE_OPA, 0);
+    lv_obj_add_flag(e->img, LV_OBJ_FLAG_HIDDEN);
+  } else {
+    lv_obj_set_style_opa(e->obj, LV_OPA_TRANSP, 0);
+    lv_obj_remove_flag(e->img, LV_OBJ_FLAG_HIDDEN);
+  }
+}
+
+static void show_look(snapshot_entry_t *e) {
+  int look = lv_obj_has_state(e->obj, LV_STATE_FOCUSED) ? LOOK_FOCUSED
+                                                        : LOOK_NORMAL;
+  lv_image_set_src(e->img, &e->buf[look]);
+  lv_obj_align_to(e->img, e->obj, LV_ALIGN_CENTER, 0, 0);
+  lv_obj_invalidate(e->img);
+}
+
+static bool render_look(snapshot_entry_t *e, int look) {
+  lv_obj_t *obj = e->obj;
+  if (look == LOOK_FOCUSED) {
+    lv_obj_add_state(obj, FOCUSED_STATES);
+  } else {
+    lv_obj_remove_state(obj, FOCUSED_STATES);
+  }
+  lv_obj_update_layout(obj);
+
+  // Same area lv_snapshot renders: object coords plus extra draw size
+  int32_t ext = lv_obj_get_ext_draw_size(obj);
+  uint32_t w = lv_obj_get_width(obj) + 2 * ext;
+  uint32_t h = lv_obj_get_height(obj) + 2 * ext;
+  uint32_t stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565);
+  uint32_t size = stride * h;
+
+  if (size > e->data_size[look]) {
+    if (e->data[look])
+      heap_caps_free(e->data[look]);
+    e->data[look] = (uint8_t *)heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size,
+                                                       MALLOC_CAP_SPIRAM);
+    e->data_size[look] = e->data[look] ? size : 0;
+    if (!e->data[look]) {
+      Serial.println("Snapshot cache: PSRAM alloc failed");
+      return false;
+    }
+  }
+
+  lv_image_cache_drop(&e->buf[look]);
+  if (lv_draw_buf_init(&e->buf[look], w, h, LV_COLOR_FORMAT_RGB565, stride,
+                       e->data[look], e->data_size[look]) != LV_RESULT_OK) {
+    return false;
+  }
+  if (lv_snapshot_take_to_draw_buf(obj, LV_COLOR_FORMAT_RGB565,
+                                   &e->buf[look]) != LV_RESULT_OK) {
+    return false;
+  }
+
+  e->fingerprint[look] = entry_fingerprint(e);
+  return true;
+}
+
+static void rebuild_entry(snapshot_entry_t *e) {
+  // Hidden objects (e.g. unused recycled cells) draw nothing; render them
+  // once they are shown and invalidated again
+  if (lv_obj_has_flag(e->obj, LV_OBJ_FLAG_HIDDEN)) {
+    internal_change = true;
+    set_live(e, true);
+    internal_change = false;
+    e->valid = false;
+    return;
+  }
+
+  uint32_t t0 = micros();
+  lv_state_t saved = lv_obj_get_state(e->obj) & FOCUSED_STATES;
+
+  internal_change = true;
+  set_live(e, true);
+  bool ok = render_look(e, LOOK_NORMAL) && render_look(e, LOOK_FOCUSED);
+
+  // Restore the real focus state
+  lv_obj_remove_state(e->obj, FOCUSED_STATES);
+  lv_obj_add_state(e->obj, saved);
+
+  e->valid = ok;
+  if (ok) {
+    set_live(e, false);
+    show_look(e);
+  } else {
+    release_buffers(e);
+  }
+  internal_change = false;
+
+  Serial.printf("Snapshot cache: rendered %p in %lu us%s\n", e->obj,
+                micros() - t0, ok ? "" : " (FAILED, drawing live)");
+}
+
+static void check_entries_cb(void *) {
+  check_scheduled = false;
+  for (auto &e : entries) {
+    if (!e.obj || !e.check_pending)
+      continue;
+    e.check_pending = false;
+
+    if (e.valid) {
+      int look = lv_obj_has_state(e.obj, LV_STATE_FOCUSED) ? LOOK_FOCUSED
+                                                           : LOOK_NORMAL;
+      // Focus moves also raise style events; only re-render if the look
+      // actually differs from what was cached
+      if (entry_fingerprint(&e) == e.fingerprint[look])
+        continue;
+    }
+    rebuild_entry(&e);
+  }
+}
+
+static void schedule_check(snapshot_entry_t *e) {
+  e->check_pending = true;
+  if (!check_scheduled) {
+    check_scheduled = true;
+    lv_async_call(check_entries_cb, nullptr);
+  }
+}
+
+static void child_event_cb(lv_event_t *ev) {
+  if (internal_change)
+    return;
+  schedule_check((snapshot_entry_t *)lv_event_get_user_data(ev));
+}
+
+// The parent gets LV_EVENT_DELETE before any of its children are deleted.
+// The image is deleted along with the parent then, so the entry lets go of it
+// here instead of deleting a sibling in the middle of the teardown.
+static void parent_event_cb(lv_event_t *ev) {
+  snapshot_entry_t *e = (snapshot_entry_t *)lv_event_get_user_data(ev);
+  release_buffers(e);
+  memset(e, 0, sizeof(*e));
+}
+
+static void obj_event_cb(lv_event_t *ev) {
+  lv_event_code_t code = lv_event_get_code(ev);
+  snapshot_entry_t *e = (snapshot_entry_t *)lv_event_get_user_data(ev);
+
+  switch (code) {
+  case LV_EVENT_FOCUSED:
+  case LV_EVENT_DEFOCUSED:
+    if (code == LV_EVENT_FOCUSED)
+      focus_move_pending = true;
+    if (e && e->valid && !internal_change)
+      show_look(e);
+    break;
+
+  case LV_EVENT_STYLE_CHANGED:
+  case LV_EVENT_SIZE_CHANGED:
+    if (e && !internal_change)
+      schedule_check(e);
+    break;
+
+  case LV_EVENT_DELETE:
+    // Cleared already if the parent is being deleted (parent_event_cb)
+    if (e && e->obj) {
+      release_buffers(e);
+      lv_obj_remove_event_cb_with_user_data(lv_obj_get_parent(e->obj),
+                                            parent_event_cb, e);
+      lv_obj_delete(e->img);
+      memset(e, 0, sizeof(*e));
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+static void display_event_cb(lv_event_t *ev) {
+  lv_event_code_t code = lv_event_get_code(ev);
+  if (code == LV_EVENT_REFR_START) {
+    refr_start_us = micros();
+  } else if (code == LV_EVENT_REFR_READY && focus_move_pending) {
+    focus_move_pending = false;
+    uint32_t dt = micros() - refr_start_us;
+    focus_moves++;
+    focus_render_total_us += dt;
+    if (dt > focus_render_max_us)
+      focus_render_max_us = dt;
+    Serial.printf("Focus move render: %lu us (cache %s)\n", dt,
+                  SNAPSHOT_CACHE_ENABLED ? "on" : "off");
+  }
+}
+
+static void hook_timing() {
+  if (timing_hooked)
+    return;
+  lv_display_t *disp = lv_display_get_default();
+  if (!disp)
+    return;
+  lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_REFR_START, NULL);
+  lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_REFR_READY, NULL);
+  timing_hooked = true;
+}
+
+void snapshot_cache_attach(lv_obj_t *obj) {
+  hook_timing();
+
+#if SNAPSHOT_CACHE_ENABLED
+  if (find_entry(obj))
+    return;
+  snapshot_entry_t *e = find_entry(nullptr);
+  if (!e) {
+    Serial.println("Snapshot cache full, drawing live");
+    lv_obj_add_event_cb(obj, obj_event_cb, LV_EVENT_FOCUSED, NULL);
+    return;
+  }
+  memset(e, 0, sizeof(*e));
+  e->obj = obj;
+
+  // Style transitions would be captured mid-way; swaps are instant anyway
+  lv_obj_set_style_transition(obj, NULL, 0);
+
+  // The image is a sibling so the object can be made transparent without
+  // hiding it (hidden objects can't take gridnav focus)
+  lv_obj_t *parent = lv_obj_get_parent(obj);
+  e->img = lv_image_create(parent);
+  lv_obj_add_flag(e->img, LV_OBJ_FLAG_IGNORE_LAYOUT | LV_OBJ_FLAG_HIDDEN);
+  lv_obj_remove_flag(e->img, LV_OBJ_FLAG_CLICKABLE |
+                                 LV_OBJ_FLAG_SCROLL_ON_FOCUS);
+
+  lv_obj_add_event_cb(obj, obj_event_cb, LV_EVENT_ALL, e);
+  lv_obj_add_event_cb(parent, parent_event_cb, LV_EVENT_DELETE, e);
+  uint32_t cnt = lv_obj_get_child_count(obj);
+  for (uint32_t i = 0; i < cnt; i++) {
+    lv_obj_add_event_cb(lv_obj_get_child(obj, i), child_event_cb,
+                        LV_EVENT_STYLE_CHANGED, e);
+  }
+
+  rebuild_entry(e);
+#else
+  lv_obj_add_event_cb(obj, obj_event_cb, LV_EVENT_FOCUSED, NULL);
+#endif
+}
+
+void snapshot_cache_invalidate(lv_obj_t *obj) {
+  snapshot_entry_t *e = find_entry(obj);
+  if (!e)
+    return;
+  e->valid = false;
+  internal_change = true;
+  set_live(e, true);
+  internal_change = false;
+  schedule_check(e);
+}
+
+void snapshot_cache_report() {
+  uint32_t avg = focus_moves ? focus_render_total_us / focus_moves : 0;
+  Serial.printf("Focus moves: %lu, render avg %lu us, max %lu us (cache %s)\n",
+                focus_moves, avg, focus_render_max_us,
+                SNAPSHOT_CACHE_ENABLED ? "on" : "off");
+}
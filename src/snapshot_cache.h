@@ -0,0 +1,28 @@
+#pragma once
+
+#include <lvgl.h>
+
+// Set to 0 to render focus changes live (for before/after timing comparison)
+#define SNAPSHOT_CACHE_ENABLED 1
+
+// Maximum number of objects that can be cached at once
+#define SNAPSHOT_CACHE_MAX_ENTRIES 16
+
+/**
+ * Pre-render an object's normal and focused looks into RGB565 images in PSRAM
+ * Focus changes then swap between the two images instead of redrawing the
+ * object. The object must already be laid out. Style or size changes on the
+ * object (or its children) invalidate the cached images automatically.
+ */
+void snapshot_cache_attach(lv_obj_t *obj);
+
+/**
+ * Drop the cached images of an object and re-render them on the next cycle
+ * Call after changes that don't raise a style event (e.g. label text)
+ */
+void snapshot_cache_invalidate(lv_obj_t *obj);
+
+/**
+ * Print per-focus-move render timing collected so far
+ */
+void snapshot_cache_report();
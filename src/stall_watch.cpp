@@ -0,0 +1,265 @@
+#include "stall_watch.h"
+#include "serial_console.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+
+enum heartbeat_t { HB_LOOP, HB_LVGL, HB_FLUSH, HB_COUNT };
+
+static const char *const hb_names[HB_COUNT] = {"loop", "lvgl", "flush"};
+static const uint32_t hb_limit_ms[HB_COUNT] = {STALL_LOOP_MS, STALL_LVGL_MS,
+                                               STALL_FLUSH_MS};
+
+static const stall_site_t unknown_site = {"?", "?"};
+
+// Written by the main loop (core 1), read by the watchdog task (core 0)
+static volatile uint32_t beat_ms[HB_COUNT]; // 0 until the first beat
+static volatile uint32_t flush_end_ms = 0;
+static volatile bool flushing = false;
+static volatile bool sleeping = false;
+static volatile uint32_t sleep_start_ms = 0;
+static const stall_site_t *volatile site = &unknown_site;
+
+struct stall_record_t {
+  uint8_t hb;
+  const stall_site_t *site;
+  uint32_t at_ms; // When the late heartbeat was last seen
+  uint32_t duration_ms;
+};
+
+// Watchdog task only: stall in progress per heartbeat
+static bool late[HB_COUNT];
+static stall_record_t open_stall[HB_COUNT];
+
+// Shared with the console (guarded by stall_mux)
+static portMUX_TYPE stall_mux = portMUX_INITIALIZER_UNLOCKED;
+static stall_record_t worst[STALL_WORST_COUNT]; // Longest first
+static uint8_t worst_count = 0;
+static uint32_t stall_count[HB_COUNT];
+static uint32_t stall_total_ms[HB_COUNT];
+static uint32_t sleep_count = 0;
+static uint32_t sleep_total_ms = 0;
+static uint32_t sleep_longest_ms = 0;
+
+// Log lines for the main loop to print; the watchdog task never writes to
+// Serial itself, so it can't cut into a capture frame or an OTA reply
+struct stall_note_t {
+  stall_record_t r;
+  bool open; // Stall just detected, duration not known yet
+};
+static stall_note_t notes[STALL_NOTE_COUNT];
+static uint8_t note_head = 0;
+static uint8_t note_count = 0;
+static uint32_t notes_dropped = 0;
+
+static bool started = false;
+
+void stall_watch_loop_beat() { beat_ms[HB_LOOP] = millis(); }
+
+void stall_watch_mark(const stall_site_t *s) { site = s; }
+
+void stall_watch_flush_begin() {
+  beat_ms[HB_FLUSH] = millis();
+  flushing = true;
+}
+
+void stall_watch_flush_end() {
+  flush_end_ms = millis();
+  flushing = false;
+}
+
+void stall_watch_sleep(bool sleep) {
+  uint32_t now = millis();
+  if (sleep) {
+    sleep_start_ms = now;
+    sleeping = true;
+    return;
+  }
+  if (!sleeping)
+    return;
+
+  uint32_t slept = now - sleep_start_ms;
+  portENTER_CRITICAL(&stall_mux);
+  sleep_count++;
+  sleep_total_ms += slept;
+  if (slept > sleep_longest_ms)
+    sleep_longest_ms = slept;
+  portEXIT_CRITICAL(&stall_mux);
+
+  // Heartbeats restart from the wake, sleep isn't a missed beat
+  beat_ms[HB_LOOP] = now;
+  if (beat_ms[HB_LVGL])
+    beat_ms[HB_LVGL] = now;
+  sleeping = false;
+}
+
+// Caller holds stall_mux
+static void queue_note(const stall_record_t *r, bool open) {
+  if (note_count == STALL_NOTE_COUNT) {
+    notes_dropped++;
+    return;
+  }
+  stall_note_t *n = &notes[(note_head + note_count++) % STALL_NOTE_COUNT];
+  n->r = *r;
+  n->open = open;
+}
+
+static void record(const stall_record_t *r) {
+  portENTER_CRITICAL(&stall_mux);
+  queue_note(r, false);
+  stall_count[r->hb]++;
+  stall_total_ms[r->hb] += r->duration_ms;
+
+  // Insert into the worst list, dropping the shortest when full
+  int pos = worst_count;
+  while (pos > 0 && worst[pos - 1].duration_ms < r->duration_ms)
+    pos--;
+  if (pos < STALL_WORST_COUNT) {
+    int last = worst_count < STALL_WORST_COUNT ? worst_count
+                                               : STALL_WORST_COUNT - 1;
+    memmove(&worst[pos + 1], &worst[pos], (last - pos) * sizeof(worst[0]));
+    worst[pos] = *r;
+    if (worst_count < STALL_WORST_COUNT)
+      worst_count++;
+  }
+  portEXIT_CRITICAL(&stall_mux);
+}
+
+static void close_stall(int hb, uint32_t end_ms) {
+  late[hb] = false;
+  stall_record_t *r = &open_stall[hb];
+  r->duration_ms = end_ms - r->at_ms;
+  record(r);
+}
+
+static void check(uint32_t now) {
+  if (sleeping) {
+    // Whatever was late stopped being a stall when sleep began
+    for (int hb = 0; hb < HB_COUNT; hb++) {
+      if (late[hb])
+        close_stall(hb, sleep_start_ms);
+    }
+    return;
+  }
+
+  for (int hb = 0; hb < HB_COUNT; hb++) {
+    uint32_t beat = beat_ms[hb];
+    bool armed = hb == HB_FLUSH ? flushing : beat != 0;
+    bool is_late = armed && (int32_t)(now - beat) > (int32_t)hb_limit_ms[hb];
+
+    if (is_late && !late[hb]) {
+      // Record what was running when the beat went missing
+      late[hb] = true;
+      open_stall[hb].hb = hb;
+      open_stall[hb].site = site;
+      open_stall[hb].at_ms = beat;
+      portENTER_CRITICAL(&stall_mux);
+      queue_note(&open_stall[hb], true);
+      portEXIT_CRITICAL(&stall_mux);
+    } else if (!is_late && late[hb]) {
+      close_stall(hb, hb == HB_FLUSH ? flush_end_ms : beat);
+    }
+  }
+}
+
+static void watch_task(void *) {
+  for (;;) {
+    check(millis());
+    vTaskDelay(pdMS_TO_TICKS(STALL_CHECK_MS));
+  }
+}
+
+void stall_watch_service() {
+  for (;;) {
+    stall_note_t n;
+    uint32_t dropped;
+    portENTER_CRITICAL(&stall_mux);
+    bool have = note_count > 0;
+    if (have) {
+      n = notes[note_head];
+      note_head = (note_head + 1) % STALL_NOTE_COUNT;
+      note_count--;
+    }
+    dropped = notes_dropped;
+    notes_dropped = 0;
+    portEXIT_CRITICAL(&stall_mux);
+
+    if (dropped)
+      Serial.printf("Stall: %lu log lines dropped\n", (unsigned long)dropped);
+    if (!have)
+      return;
+    if (n.open) {
+      Serial.printf("Stall: %s stall in progress in %s/%s (beat at %lu ms)\n",
+                    hb_names[n.r.hb], n.r.site->func, n.r.site->phase,
+                    (unsigned long)n.r.at_ms);
+    } else {
+      Serial.printf("Stall: %s %lu ms in %s/%s\n", hb_names[n.r.hb],
+                    (unsigned long)n.r.duration_ms, n.r.site->func,
+                    n.r.site->phase);
+    }
+  }
+}
+
+static void lvgl_beat_cb(lv_timer_t *) { beat_ms[HB_LVGL] = millis(); }
+
+void stall_watch_report() {
+  stall_record_t list[STALL_WORST_COUNT];
+  uint32_t count[HB_COUNT], total[HB_COUNT];
+  uint32_t n_sleep, slept, longest;
+  uint8_t n;
+
+  portENTER_CRITICAL(&stall_mux);
+  n = worst_count;
+  memcpy(list, worst, sizeof(list));
+  memcpy(count, stall_count, sizeof(count));
+  memcpy(total, stall_total_ms, sizeof(total));
+  n_sleep = sleep_count;
+  slept = sleep_total_ms;
+  longest = sleep_longest_ms;
+  portEXIT_CRITICAL(&stall_mux);
+
+  Serial.printf("Stalls: loop %lu (%lu ms), lvgl %lu (%lu ms), "
+                "flush %lu (%lu ms)\n",
+                (unsigned long)count[HB_LOOP], (unsigned long)total[HB_LOOP],
+                (unsigned long)count[HB_LVGL], (unsigned long)total[HB_LVGL],
+                (unsigned long)count[HB_FLUSH], (unsigned long)total[HB_FLUSH]);
+  Serial.printf("  Sleep: %lu times, %lu ms total, longest %lu ms\n",
+                (unsigned long)n_sleep, (unsigned long)slept,
+                (unsigned long)longest);
+  for (uint8_t i = 0; i < n; i++) {
+    Serial.printf("  %u. %-5s %5lu ms at %lu ms in %s/%s\n", i + 1,
+                  hb_names[list[i].hb], (unsigned long)list[i].duration_ms,
+                  (unsigned long)list[i].at_ms, list[i].site->func,
+                  list[i].site->phase);
+  }
+}
+
+static void stall_command(const char *args) {
+  if (strcmp(args, "clear") == 0) {
+    portENTER_CRITICAL(&stall_mux);
+    worst_count = 0;
+    memset(stall_count, 0, sizeof(stall_count));
+    memset(stall_total_ms, 0, sizeof(stall_total_ms));
+    sleep_count = sleep_total_ms = sleep_longest_ms = 0;
+    portEXIT_CRITICAL(&stall_mux);
+    Serial.println("Stalls cleared");
+  } else if (*args == '\0') {
+    stall_watch_report();
+  } else {
+    Serial.println("usage: stall [clear]");
+  }
+}
+
+void stall_watch_begin() {
+  if (started)
+    return;
+  started = true;
+
+  beat_ms[HB_LOOP] = millis();
+  lv_timer_create(lvgl_beat_cb, STALL_LVGL_BEAT_MS, NULL);
+  serial_console_register("stall", stall_command);
+
+  // Core 0, so it keeps checking while the loop on core 1 is stuck
+  xTaskCreatePinnedToCore(watch_task, "stall_watch", 3072, NULL, 2, NULL, 0);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stdint.h>
+
+// A heartbeat later than this counts as a stall
+#define STALL_LOOP_MS 100  // Main loop pass
+#define STALL_LVGL_MS 100  // LVGL timer handler (beat timer below)
+#define STALL_FLUSH_MS 50  // A single flush call
+
+// Period of the LVGL timer that beats for the timer handler
+#define STALL_LVGL_BEAT_MS 10
+
+// Watchdog task check period
+#define STALL_CHECK_MS 10
+
+// Longest stalls kept for "stall" on the console
+#define STALL_WORST_COUNT 8
+
+// Stall log lines waiting for stall_watch_service(); more are dropped
+#define STALL_NOTE_COUNT 8
+
+/**
+ * Start the watchdog task on core 0, the LVGL beat timer and the "stall"
+ * console command ("stall [clear]"). Call at the end of setup() so boot
+ * work (calibration) isn't counted.
+ */
+void stall_watch_begin();
+
+/**
+ * Main loop heartbeat (call at the top of every pass)
+ */
+void stall_watch_loop_beat();
+
+// Where the main loop is; recorded with any stall detected while it runs
+struct stall_site_t {
+  const char *func;
+  const char *phase;
+};
+
+/**
+ * Mark the current function and phase (phase must be a string literal):
+ *   STALL_PHASE("lcd wake");
+ */
+#define STALL_PHASE(phase)                                                     \
+  do {                                                                         \
+    static const stall_site_t stall_site_ = {__func__, phase};                 \
+    stall_watch_mark(&stall_site_);                                            \
+  } while (0)
+
+void stall_watch_mark(const stall_site_t *site);
+
+/**
+ * Bracket a flush call; a flush running longer than STALL_FLUSH_MS is a
+ * stall in the flush path
+ */
+void stall_watch_flush_begin();
+void stall_watch_flush_end();
+
+/**
+ * Bracket deliberate blocking sleep (light sleep); the time is counted as
+ * sleep, not as a stall
+ */
+void stall_watch_sleep(bool sleeping);
+
+/**
+ * Print the stall log lines the watchdog task queued ("stall in progress"
+ * when a heartbeat goes missing, the duration once it recovers). Call from
+ * the main loop so they never interleave with capture or OTA traffic.
+ */
+void stall_watch_service();
+
+/**
+ * Print the worst stalls, per-heartbeat counts and sleep time
+ */
+void stall_watch_report();
@@ -28,14 +28,17 @@ public:
   }
 
   void setRGBW(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    uint8_t values[4] = {r, g, b, w};
+    setLEDs(0, values, 4);
+  }
+
+  // Write count consecutive LED channels starting at first (0=R .. 3=W)
+  void setLEDs(uint8_t first, const uint8_t *values, uint8_t count) {
     if (!_wire)
       return;
     _wire->beginTransmission(_addr);
-    _wire->write(0x00); // LED register
-    _wire->write(r);
-    _wire->write(g);
-    _wire->write(b);
-    _wire->write(w);
+    _wire->write(0x00 + first); // LED register
+    _wire->write(values, count);
     _wire->endTransmission();
   }
 
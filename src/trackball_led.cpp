@@ -0,0 +1,103 @@
+#include "trackball_led.h"
+#include <Arduino.h>
+#include <lvgl.h>
+#include <string.h>
+
+static Trackball *led_tb = nullptr;
+static lv_timer_t *frame_timer = nullptr;
+static led_effects_t effects;
+static led_writer_t writer;
+
+// Latest frame from the timer, waiting for trackball_led_service()
+static led_rgbw_t pending;
+static bool frame_ready = false;
+
+static void frame_timer_cb(lv_timer_t *timer) {
+  pending = led_effects_frame(&effects, millis());
+  frame_ready = true;
+
+  // Nothing left to animate: sleep until the next effect call
+  if (!led_effects_animating(&effects))
+    lv_timer_pause(timer);
+}
+
+// Produce a frame on the next timer pass and keep going while animating
+static void kick() {
+  if (!frame_timer)
+    return;
+  lv_timer_resume(frame_timer);
+  lv_timer_ready(frame_timer);
+}
+
+static void write(const led_write_t *w) {
+  led_tb->setLEDs(w->first, w->values, w->count);
+}
+
+void trackball_led_begin(Trackball *tb, led_rgbw_t color) {
+  led_tb = tb;
+  led_effects_init(&effects, color);
+  led_writer_init(&writer, TRACKBALL_LED_I2C_BUDGET, millis());
+
+  led_write_t w;
+  led_writer_force(&writer, &color, &w);
+  write(&w);
+
+  frame_timer = lv_timer_create(frame_timer_cb, TRACKBALL_LED_FRAME_MS, NULL);
+  lv_timer_pause(frame_timer);
+}
+
+void trackball_led_transition(led_rgbw_t color, uint32_t duration_ms) {
+  led_effects_transition(&effects, color, millis(), duration_ms);
+  kick();
+}
+
+void trackball_led_pulse(led_rgbw_t color, uint32_t duration_ms) {
+  led_effects_pulse(&effects, color, millis(), duration_ms);
+  kick();
+}
+
+void trackball_led_breathe(led_rgbw_t color, uint32_t period_ms) {
+  led_effects_breathe(&effects, color, millis(), period_ms);
+  kick();
+}
+
+void trackball_led_flash(led_rgbw_t color, uint32_t flash_ms) {
+  led_effects_flash(&effects, color, millis(), flash_ms);
+  kick();
+}
+
+void trackball_led_set_now(led_rgbw_t color) {
+  led_effects_solid(&effects, color);
+  effects.flash_active = false;
+  effects.last = color;
+  frame_ready = false;
+
+  // Skip the bus entirely if the LED already shows it
+  if (writer.synced && memcmp(&writer.sent, &color, sizeof(color)) == 0)
+    return;
+  led_write_t w;
+  led_writer_force(&writer, &color, &w);
+  write(&w);
+}
+
+void trackball_led_service() {
+  if (!frame_ready || !led_tb)
+    return;
+
+  led_write_t w;
+  if (led_writer_plan(&writer, &pending, millis(), &w))
+    write(&w);
+
+  // A frame held back by the budget stays pending so the final colour of
+  // an effect is never lost; newer frames simply replace it
+  frame_ready = memcmp(&writer.sent, &pending, sizeof(pending)) != 0;
+}
+
+void trackball_led_report() {
+  Serial.printf("LED: %lu frames, %lu writes (%lu bytes), skipped %lu "
+                "unchanged / %lu over budget (%d/s)\n",
+                (unsigned long)writer.frames, (unsigned long)writer.writes,
+                (unsigned long)writer.bytes,
+                (unsigned long)writer.skipped_same,
+                (unsigned long)writer.skipped_budget, TRACKBALL_LED_I2C_BUDGET);
+}
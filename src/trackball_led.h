@@ -0,0 +1,51 @@
+#pragma once
+
+#include "led_effects.h"
+#include "trackball.h"
+
+// Frame rate of the LED effect timer
+#define TRACKBALL_LED_FRAME_MS 20
+
+// Maximum LED writes per second on the shared I2C bus
+#define TRACKBALL_LED_I2C_BUDGET 25
+
+/**
+ * Start the effect timer and write the initial colour
+ */
+void trackball_led_begin(Trackball *tb, led_rgbw_t color);
+
+/**
+ * Cross-fade to a colour
+ */
+void trackball_led_transition(led_rgbw_t color, uint32_t duration_ms);
+
+/**
+ * One swell to a colour and back
+ */
+void trackball_led_pulse(led_rgbw_t color, uint32_t duration_ms);
+
+/**
+ * Breathe a colour until another effect is set
+ */
+void trackball_led_breathe(led_rgbw_t color, uint32_t period_ms);
+
+/**
+ * Short flash on top of the current effect (click acknowledgement)
+ */
+void trackball_led_flash(led_rgbw_t color, uint32_t flash_ms);
+
+/**
+ * Set a colour and write it right away, ignoring the budget (sleep entry)
+ */
+void trackball_led_set_now(led_rgbw_t color);
+
+/**
+ * Send the latest frame if it changed and the budget allows. Call right
+ * after trackball.update() so a write never sits in front of a read.
+ */
+void trackball_led_service();
+
+/**
+ * Print frame/write statistics
+ */
+void trackball_led_report();
@@ -1,6 +1,11 @@
 #include "ui.h"
+#include "mem_tiered.h"
 #include "qspi_display.h"
+#include "screen_manager.h"
+#include "settings.h"
+#include "snapshot_cache.h"
 #include "trackball.h"
+#include "virtual_grid.h"
 #include <Arduino.h>
 #include <lvgl.h>
 
@@ -10,6 +15,10 @@ extern Trackball trackball;
 // External function to save LED color for sleep/wake
 extern void set_trackball_led_color(uint8_t r, uint8_t g, uint8_t b, uint8_t w);
 
+// Number of grid items (raise to 100/1000 to exercise virtualisation;
+// items past the first nine repeat the colour palette)
+#define UI_ITEM_COUNT 9
+
 // Button colors (RGB hex values)
 static uint32_t colors[] = {
     0xff0000, 0x00ff00, 0x0000ff, // Red, Green, Blue
@@ -21,8 +30,100 @@ static uint32_t colors[] = {
 static const char *labels[] = {"Red",  "Green", "Blue",  "Yellow", "Off",
                                "Cyan", "Pink",  "White", "Orange"};
 
-void ui_init() {
-  lv_obj_t *scr = lv_screen_active();
+#define PALETTE_SIZE (sizeof(colors) / sizeof(colors[0]))
+#define OFF_INDEX 4
+
+// Click handler to sync trackball LED color
+static void button_clicked_cb(lv_event_t *e) {
+  lv_obj_t *btn = (lv_obj_t *)lv_event_get_current_target(e);
+  uint32_t item = virtual_grid_get_index(btn);
+  if (item == UINT32_MAX)
+    return;
+
+  int idx = item % PALETTE_SIZE;
+  uint32_t c = colors[idx];
+  uint8_t r = (c >> 16) & 0xFF;
+  uint8_t g = (c >> 8) & 0xFF;
+  uint8_t b = c & 0xFF;
+
+  if (idx == OFF_INDEX) { // Off
+    set_trackball_led_color(0, 0, 0, 0);
+    Serial.println("Trackball: OFF");
+  } else if (idx == 7) { // White button - Use pure white LED
+    set_trackball_led_color(0, 0, 0, 255);
+    Serial.println("Trackball: Pure White");
+  } else if (idx == 2) { // Blue button - Augment with some white for
+                         // brightness
+    set_trackball_led_color(0, 0, 255, 50);
+    Serial.println("Trackball: Blue + White");
+  } else {
+    set_trackball_led_color(r, g, b, 0);
+    Serial.printf("Trackball: R=%d G=%d B=%d W=0\n", r, g, b);
+  }
+}
+
+// Remember the focused item so it survives a reboot
+static void button_focused_cb(lv_event_t *e) {
+  lv_obj_t *btn = (lv_obj_t *)lv_event_get_current_target(e);
+  uint32_t item = virtual_grid_get_index(btn);
+  if (item != UINT32_MAX)
+    settings_set_focused(item);
+}
+
+// Create one pooled button (item-independent styling only)
+static lv_obj_t *create_button(lv_obj_t *parent) {
+  lv_obj_t *btn = lv_button_create(parent);
+  lv_obj_set_style_radius(btn, 8, 0);
+
+  // ADDED: Make focus more visible with internal border
+  lv_obj_set_style_border_width(btn, 0, 0);
+  lv_obj_set_style_border_width(btn, 6,
+                                LV_STATE_FOCUSED); // 6px internal border
+  lv_obj_set_style_border_color(btn, lv_palette_main(LV_PALETTE_GREY),
+                                LV_STATE_FOCUSED); // Medium Gray
+  lv_obj_set_style_border_side(btn, LV_BORDER_SIDE_FULL, LV_STATE_FOCUSED);
+  lv_obj_set_style_border_opa(btn, LV_OPA_COVER, LV_STATE_FOCUSED);
+
+  // Create label
+  lv_obj_t *label = lv_label_create(btn);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_24, 0);
+  lv_obj_center(label);
+
+  lv_obj_add_event_cb(btn, button_clicked_cb, LV_EVENT_CLICKED, NULL);
+  lv_obj_add_event_cb(btn, button_focused_cb, LV_EVENT_FOCUSED, NULL);
+  return btn;
+}
+
+// Show item `index` on a recycled button
+static void bind_button(lv_obj_t *btn, uint32_t index) {
+  int idx = index % PALETTE_SIZE;
+  lv_obj_t *label = lv_obj_get_child(btn, 0);
+
+  // Button background color, kept when focused
+  uint32_t color = (idx == OFF_INDEX) ? 0x222222 : colors[idx];
+  lv_obj_set_style_bg_color(btn, lv_color_hex(color), 0);
+  lv_obj_set_style_bg_color(btn, lv_color_hex(color), LV_STATE_FOCUSED);
+
+  if (UI_ITEM_COUNT <= PALETTE_SIZE) {
+    lv_label_set_text(label, labels[idx]);
+  } else {
+    lv_label_set_text_fmt(label, "%s %lu", labels[idx],
+                          (unsigned long)index + 1);
+  }
+
+  // Special styling for "Off" button (dark background)
+  lv_obj_set_style_text_color(
+      label, (idx == OFF_INDEX) ? lv_color_white() : lv_color_black(), 0);
+
+  snapshot_cache_invalidate(btn);
+}
+
+static void unbind_button(lv_obj_t *btn, uint32_t) {
+  snapshot_cache_invalidate(btn);
+}
+
+// Grid page: the colour buttons
+static lv_obj_t *build_grid_page(lv_obj_t *scr, lv_group_t *group) {
   lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
 
   // Create a container for the grid
@@ -32,110 +133,113 @@ void ui_init() {
   lv_obj_set_style_bg_opa(cont, LV_OPA_TRANSP, 0);
   lv_obj_set_style_border_width(cont, 0, 0);
   lv_obj_set_style_pad_all(cont, 5, 0);
-  lv_obj_set_layout(cont, LV_LAYOUT_GRID);
-
-  // Define grid columns and rows (3x3)
-  static int32_t col_dsc[] = {LV_GRID_FR(1), LV_GRID_FR(1), LV_GRID_FR(1),
-                              LV_GRID_TEMPLATE_LAST};
-  static int32_t row_dsc[] = {LV_GRID_FR(1), LV_GRID_FR(1), LV_GRID_FR(1),
-                              LV_GRID_TEMPLATE_LAST};
-  lv_obj_set_grid_dsc_array(cont, col_dsc, row_dsc);
-
-  // Enable gridnav on the container for 2D navigation
-  lv_gridnav_add(cont, LV_GRIDNAV_CTRL_ROLLOVER);
-
-  // Create buttons in grid
-  for (int i = 0; i < 9; i++) {
-    int row = i / 3;
-    int col = i % 3;
-
-    lv_obj_t *btn = lv_button_create(cont);
-    lv_obj_set_grid_cell(btn, LV_GRID_ALIGN_STRETCH, col, 1,
-                         LV_GRID_ALIGN_STRETCH, row, 1);
-
-    // Button background color
-    uint32_t color = colors[i];
-    lv_obj_set_style_bg_color(btn, lv_color_hex(color), 0);
-    lv_obj_set_style_radius(btn, 8, 0);
-
-    // Keep button background color when focused
-    lv_obj_set_style_bg_color(btn, lv_color_hex(color), LV_STATE_FOCUSED);
-
-    // ADDED: Make focus more visible with internal border
-    lv_obj_set_style_border_width(btn, 0, 0);
-    lv_obj_set_style_border_width(btn, 6,
-                                  LV_STATE_FOCUSED); // 6px internal border
-    lv_obj_set_style_border_color(btn, lv_palette_main(LV_PALETTE_GREY),
-                                  LV_STATE_FOCUSED); // Medium Gray
-    lv_obj_set_style_border_side(btn, LV_BORDER_SIDE_FULL, LV_STATE_FOCUSED);
-    lv_obj_set_style_border_opa(btn, LV_OPA_COVER, LV_STATE_FOCUSED);
-
-    // Create label
-    lv_obj_t *label = lv_label_create(btn);
-    lv_label_set_text(label, labels[i]);
-    lv_obj_set_style_text_font(label, &lv_font_montserrat_24, 0);
-    lv_obj_center(label);
-
-    // Special styling for "Off" button (dark background)
-    if (i == 4) {
-      lv_obj_set_style_bg_color(btn, lv_color_hex(0x222222), 0);
-      lv_obj_set_style_bg_color(btn, lv_color_hex(0x222222), LV_STATE_FOCUSED);
-      lv_obj_set_style_text_color(label, lv_color_white(), 0);
-    } else {
-      lv_obj_set_style_text_color(label, lv_color_black(), 0);
-    }
 
-    // Click handler to sync trackball LED color
-    lv_obj_add_event_cb(
-        btn,
-        [](lv_event_t *e) {
-          int idx = (intptr_t)lv_event_get_user_data(e);
-          uint32_t c = colors[idx];
-          uint8_t r = (c >> 16) & 0xFF;
-          uint8_t g = (c >> 8) & 0xFF;
-          uint8_t b = c & 0xFF;
-
-          if (idx == 4) { // Off
-            set_trackball_led_color(0, 0, 0, 0);
-            Serial.println("Trackball: OFF");
-          } else if (idx == 7) { // White button - Use pure white LED
-            set_trackball_led_color(0, 0, 0, 255);
-            Serial.println("Trackball: Pure White");
-          } else if (idx == 2) { // Blue button - Augment with some white for
-                                 // brightness
-            set_trackball_led_color(0, 0, 255, 50);
-            Serial.println("Trackball: Blue + White");
-          } else {
-            set_trackball_led_color(r, g, b, 0);
-            Serial.printf("Trackball: R=%d G=%d B=%d W=0\n", r, g, b);
-          }
-        },
-        LV_EVENT_CLICKED, (void *)(intptr_t)i);
+  // Data-driven 3-column grid; only visible rows (+1 margin) are created,
+  // gridnav handles 2D navigation
+  virtual_grid_config_t grid_cfg = {};
+  grid_cfg.count = UI_ITEM_COUNT;
+  grid_cfg.columns = 3;
+  grid_cfg.visible_rows = 3;
+  grid_cfg.margin_rows = 1;
+  grid_cfg.create_cb = create_button;
+  grid_cfg.bind_cb = bind_button;
+  grid_cfg.unbind_cb = unbind_button;
+  if (!virtual_grid_init(cont, &grid_cfg))
+    return nullptr;
+
+  // Pre-render each button's normal/focused look so focus moves only blit
+  lv_obj_update_layout(scr);
+  uint32_t pool_size = virtual_grid_get_pool_size(cont);
+  for (uint32_t i = 0; i < pool_size; i++) {
+    snapshot_cache_attach(virtual_grid_get_pool_cell(cont, i));
   }
 
-  // Create group and associate with input device
-  lv_group_t *g = lv_group_create();
-  lv_group_add_obj(g, cont);
+  // gridnav moves focus between the buttons inside the container
+  lv_group_add_obj(group, cont);
 
-  // Associate group with keypad input device
+  // Focus the button that was focused last (also across reboots)
+  uint32_t focus = settings_get()->focused_index;
+  if (focus >= UI_ITEM_COUNT)
+    focus = 0;
+  lv_obj_t *first_btn = virtual_grid_show_index(cont, focus);
+  if (first_btn) {
+    // The cell isn't in the group, gridnav has to be told which one it is
+    // (it would otherwise pick the first child when the container is focused)
+    lv_gridnav_set_focused(cont, first_btn, LV_ANIM_OFF);
+    Serial.printf("Focusing button %lu\n", (unsigned long)focus);
+  } else {
+    Serial.println("WARNING: Could not find first button to focus!");
+  }
+  return first_btn;
+}
+
+static void status_timer_cb(lv_timer_t *t) {
+  lv_obj_t *label = (lv_obj_t *)lv_timer_get_user_data(t);
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  const settings_t *s = settings_get();
+  lv_label_set_text_fmt(label,
+                        "Uptime %lu s\n"
+                        "LVGL heap %lu / %lu bytes (%u%%, internal %u%%)\n"
+                        "Brightness %u, idle timeout %lu s",
+                        millis() / 1000,
+                        (unsigned long)(mon.total_size - mon.free_size),
+                        (unsigned long)mon.total_size, mon.used_pct,
+                        mem_tiered_internal_used_pct(), s->brightness,
+                        (unsigned long)s->idle_timeout_ms / 1000);
+}
+
+static void status_label_deleted_cb(lv_event_t *e) {
+  lv_timer_delete((lv_timer_t *)lv_event_get_user_data(e));
+}
+
+static void back_clicked_cb(lv_event_t *) {
+  screen_manager_show(screen_manager_find("grid"));
+}
+
+// Status page: live system numbers and a way back to the grid
+static lv_obj_t *build_status_page(lv_obj_t *scr, lv_group_t *group) {
+  lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+
+  lv_obj_t *label = lv_label_create(scr);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_24, 0);
+  lv_obj_set_style_text_color(label, lv_color_white(), 0);
+  lv_obj_align(label, LV_ALIGN_TOP_LEFT, 16, 16);
+
+  // Refreshed while the page exists; the timer goes with the label
+  lv_timer_t *timer = lv_timer_create(status_timer_cb, 1000, label);
+  lv_obj_add_event_cb(label, status_label_deleted_cb, LV_EVENT_DELETE, timer);
+  status_timer_cb(timer);
+
+  lv_obj_t *back = lv_button_create(scr);
+  lv_obj_set_size(back, 140, 56);
+  lv_obj_align(back, LV_ALIGN_BOTTOM_RIGHT, -16, -16);
+  lv_obj_set_style_border_width(back, 6, LV_STATE_FOCUSED);
+  lv_obj_set_style_border_color(back, lv_palette_main(LV_PALETTE_GREY),
+                                LV_STATE_FOCUSED);
+  lv_obj_t *back_label = lv_label_create(back);
+  lv_obj_set_style_text_font(back_label, &lv_font_montserrat_24, 0);
+  lv_label_set_text(back_label, "Back");
+  lv_obj_center(back_label);
+  lv_obj_add_event_cb(back, back_clicked_cb, LV_EVENT_CLICKED, NULL);
+  lv_group_add_obj(group, back);
+  return back;
+}
+
+void ui_init() {
+  // Find the keypad input device so each page's group can be bound to it
   lv_indev_t *indev = NULL;
   while ((indev = lv_indev_get_next(indev)) != NULL) {
     if (lv_indev_get_type(indev) == LV_INDEV_TYPE_KEYPAD) {
-      lv_indev_set_group(indev, g);
-      Serial.println("Keypad input device found and linked to group");
+      Serial.println("Keypad input device found");
       break;
     }
   }
+  screen_manager_begin(indev);
 
-  // Set as default group
-  lv_group_set_default(g);
-
-  // Focus the first button
-  lv_obj_t *first_btn = lv_obj_get_child(cont, 0);
-  if (first_btn) {
-    Serial.println("Focusing first button");
-    lv_group_focus_obj(first_btn);
-  } else {
-    Serial.println("WARNING: Could not find first button to focus!");
-  }
+  // Pages are built on first use; the grid is kept as a snapshot when it
+  // has to be released so going back to it is instant
+  int grid = screen_manager_add("grid", build_grid_page, true);
+  screen_manager_add("status", build_status_page, false);
+  screen_manager_show(grid);
 }
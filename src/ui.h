@@ -3,7 +3,7 @@
 #include <lvgl.h>
 
 /**
- * Initialize the 3x3 color picker UI
- * Creates a grid of color buttons with trackball navigation
+ * Register the UI pages and show the 3x3 color picker grid
+ * ("screen status" on the console opens the status page)
  */
 void ui_init();
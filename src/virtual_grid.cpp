@@ -0,0 +1,276 @@
+#include "virtual_grid.h"
+#include <Arduino.h>
+
+struct virtual_grid_t {
+  virtual_grid_config_t cfg;
+  lv_obj_t *cont;
+  lv_obj_t *spacer; // Sets the scrollable height of the full data set
+  lv_obj_t **cells; // pool_rows * columns, slot-major
+  int32_t *bound_row; // Logical row bound to each pool slot (-1 = none)
+  uint32_t total_rows;
+  uint32_t pool_rows;
+  int32_t cell_w;
+  int32_t row_h;
+  int32_t gap_x;
+  int32_t gap_y;
+
+  // Render time of the frames drawn while the container scrolls
+  bool scroll_anim;    // Between SCROLL_BEGIN and SCROLL_END
+  bool scroll_dirty;   // Scrolled since the last refresh started
+  bool timing_frame;   // The refresh in progress follows a scroll
+  uint32_t refr_start_us;
+  uint32_t scroll_frames;
+  uint32_t scroll_total_us;
+  uint32_t scroll_max_us;
+  uint32_t rebind_us; // Rebinding done during the scroll
+  uint32_t rebound_rows;
+};
+
+static virtual_grid_t *get_grid(lv_obj_t *cont) {
+  return (virtual_grid_t *)lv_obj_get_user_data(cont);
+}
+
+static int32_t row_pitch(const virtual_grid_t *vg) {
+  return vg->row_h + vg->gap_y;
+}
+
+static void bind_row(virtual_grid_t *vg, uint32_t slot, uint32_t row) {
+  uint8_t cols = vg->cfg.columns;
+  for (uint8_t c = 0; c < cols; c++) {
+    lv_obj_t *cell = vg->cells[slot * cols + c];
+    uint32_t index = row * cols + c;
+    if (index >= vg->cfg.count) {
+      lv_obj_add_flag(cell, LV_OBJ_FLAG_HIDDEN);
+      lv_obj_set_user_data(cell, nullptr);
+      if (vg->cfg.unbind_cb)
+        vg->cfg.unbind_cb(cell, index);
+      continue;
+    }
+    lv_obj_remove_flag(cell, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_pos(cell, c * (vg->cell_w + vg->gap_x), row * row_pitch(vg));
+    // Store index + 1 so a null user data means "not bound"
+    lv_obj_set_user_data(cell, (void *)(uintptr_t)(index + 1));
+    vg->cfg.bind_cb(cell, index);
+  }
+  vg->bound_row[slot] = row;
+}
+
+// Rebind pool slots so they cover the visible rows plus margins. Rows map to
+// slots modulo the pool size, so scrolling by one row rebinds only one row.
+static void update_window(virtual_grid_t *vg) {
+  int32_t first = lv_obj_get_scroll_y(vg->cont) / row_pitch(vg) -
+                  vg->cfg.margin_rows;
+  int32_t last_first = (int32_t)vg->total_rows - (int32_t)vg->pool_rows;
+  if (first > last_first)
+    first = last_first;
+  if (first < 0)
+    first = 0;
+
+  uint32_t t0 = micros();
+  uint32_t rebound = 0;
+  for (uint32_t r = first; r < first + vg->pool_rows; r++) {
+    uint32_t slot = r % vg->pool_rows;
+    if (vg->bound_row[slot] != (int32_t)r) {
+      bind_row(vg, slot, r);
+      rebound++;
+    }
+  }
+
+  vg->rebind_us += micros() - t0;
+  vg->rebound_rows += rebound;
+  if (rebound && vg->pool_rows < vg->total_rows) {
+    Serial.printf("Grid window: rows %ld-%ld, %lu rows rebound in %lu us\n",
+                  (long)first, (long)(first + vg->pool_rows - 1),
+                  (unsigned long)rebound, micros() - t0);
+  }
+}
+
+static void report_scroll(virtual_grid_t *vg) {
+  if (vg->scroll_frames) {
+    Serial.printf("Grid scroll: %lu items, %lu frames, avg %lu us, max %lu "
+                  "us, %lu rows rebound in %lu us\n",
+                  (unsigned long)vg->cfg.count,
+                  (unsigned long)vg->scroll_frames,
+                  (unsigned long)(vg->scroll_total_us / vg->scroll_frames),
+                  (unsigned long)vg->scroll_max_us,
+                  (unsigned long)vg->rebound_rows,
+                  (unsigned long)vg->rebind_us);
+  }
+  vg->scroll_frames = 0;
+  vg->scroll_total_us = 0;
+  vg->scroll_max_us = 0;
+  vg->rebind_us = 0;
+  vg->rebound_rows = 0;
+}
+
+static void display_event_cb(lv_event_t *e) {
+  virtual_grid_t *vg = (virtual_grid_t *)lv_event_get_user_data(e);
+  if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+    vg->timing_frame = vg->scroll_dirty;
+    vg->scroll_dirty = false;
+    vg->refr_start_us = micros();
+    return;
+  }
+  if (!vg->timing_frame)
+    return;
+  vg->timing_frame = false;
+
+  uint32_t dt = micros() - vg->refr_start_us;
+  vg->scroll_frames++;
+  vg->scroll_total_us += dt;
+  if (dt > vg->scroll_max_us)
+    vg->scroll_max_us = dt;
+  // Jumps without animation (e.g. show_index) have no SCROLL_END
+  if (!vg->scroll_anim)
+    report_scroll(vg);
+}
+
+static void grid_event_cb(lv_event_t *e) {
+  lv_obj_t *cont = (lv_obj_t *)lv_event_get_current_target(e);
+  virtual_grid_t *vg = get_grid(cont);
+  if (!vg)
+    return;
+
+  switch (lv_event_get_code(e)) {
+  case LV_EVENT_SCROLL_BEGIN:
+    vg->scroll_anim = true;
+    break;
+  case LV_EVENT_SCROLL:
+    vg->scroll_dirty = true;
+    update_window(vg);
+    break;
+  case LV_EVENT_SCROLL_END:
+    vg->scroll_anim = false;
+    report_scroll(vg);
+    break;
+  case LV_EVENT_DELETE:
+    lv_display_remove_event_cb_with_user_data(lv_obj_get_display(cont),
+                                              display_event_cb, vg);
+    lv_free(vg->cells);
+    lv_free(vg->bound_row);
+    lv_free(vg);
+    lv_obj_set_user_data(cont, nullptr);
+    break;
+  default:
+    break;
+  }
+}
+
+bool virtual_grid_init(lv_obj_t *cont, const virtual_grid_config_t *cfg) {
+  uint32_t t0 = micros();
+
+  virtual_grid_t *vg = (virtual_grid_t *)lv_malloc_zeroed(sizeof(*vg));
+  if (!vg) {
+    Serial.println("Grid state alloc failed");
+    return false;
+  }
+  vg->cfg = *cfg;
+  vg->cont = cont;
+  vg->total_rows = (cfg->count + cfg->columns - 1) / cfg->columns;
+  vg->pool_rows = cfg->visible_rows + 2 * cfg->margin_rows;
+  if (vg->pool_rows > vg->total_rows)
+    vg->pool_rows = vg->total_rows;
+
+  // Allocate before touching the container so a failure leaves it as it was
+  uint32_t pool_size = vg->pool_rows * cfg->columns;
+  vg->cells = (lv_obj_t **)lv_malloc(pool_size * sizeof(lv_obj_t *));
+  vg->bound_row = (int32_t *)lv_malloc(vg->pool_rows * sizeof(int32_t));
+  if (!vg->cells || !vg->bound_row) {
+    Serial.println("Grid pool alloc failed");
+    lv_free(vg->cells);
+    lv_free(vg->bound_row);
+    lv_free(vg);
+    return false;
+  }
+
+  // Cells are placed manually, so take the spacing from the container style
+  lv_obj_update_layout(cont);
+  vg->gap_x = lv_obj_get_style_pad_column(cont, 0);
+  vg->gap_y = lv_obj_get_style_pad_row(cont, 0);
+  int32_t content_w = lv_obj_get_content_width(cont);
+  int32_t content_h = lv_obj_get_content_height(cont);
+  vg->cell_w = (content_w - vg->gap_x * (cfg->columns - 1)) / cfg->columns;
+  vg->row_h = (content_h - vg->gap_y * (cfg->visible_rows - 1)) /
+              cfg->visible_rows;
+
+  lv_obj_set_layout(cont, LV_LAYOUT_NONE);
+  lv_obj_set_scroll_dir(cont, LV_DIR_VER);
+  lv_obj_set_user_data(cont, vg);
+
+  for (uint32_t i = 0; i < pool_size; i++) {
+    vg->cells[i] = cfg->create_cb(cont);
+    lv_obj_set_size(vg->cells[i], vg->cell_w, vg->row_h);
+  }
+  for (uint32_t s = 0; s < vg->pool_rows; s++) {
+    vg->bound_row[s] = -1;
+  }
+
+  // Invisible object at the bottom of the full data set so the container
+  // scrolls over every row, not just the pooled ones
+  vg->spacer = lv_obj_create(cont);
+  lv_obj_remove_style_all(vg->spacer);
+  lv_obj_remove_flag(vg->spacer,
+                     LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_CLICK_FOCUSABLE);
+  lv_obj_set_size(vg->spacer, 1, 1);
+  lv_obj_set_pos(vg->spacer, 0, vg->total_rows * row_pitch(vg) - vg->gap_y - 1);
+
+  // Rollover would wrap to the first pooled row rather than the first item
+  bool all_pooled = vg->pool_rows >= vg->total_rows;
+  lv_gridnav_add(cont, all_pooled ? LV_GRIDNAV_CTRL_ROLLOVER
+                                  : LV_GRIDNAV_CTRL_NONE);
+
+  lv_obj_add_event_cb(cont, grid_event_cb, LV_EVENT_SCROLL_BEGIN, NULL);
+  lv_obj_add_event_cb(cont, grid_event_cb, LV_EVENT_SCROLL, NULL);
+  lv_obj_add_event_cb(cont, grid_event_cb, LV_EVENT_SCROLL_END, NULL);
+  lv_obj_add_event_cb(cont, grid_event_cb, LV_EVENT_DELETE, NULL);
+  lv_display_t *disp = lv_obj_get_display(cont);
+  lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_REFR_START, vg);
+  lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_REFR_READY, vg);
+  update_window(vg);
+
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  Serial.printf("Grid: %lu items, %lu cells pooled, built in %lu us, "
+                "LVGL heap used %lu bytes\n",
+                (unsigned long)cfg->count, (unsigned long)pool_size,
+                micros() - t0,
+                (unsigned long)(mon.total_size - mon.free_size));
+  return true;
+}
+
+uint32_t virtual_grid_get_index(lv_obj_t *cell) {
+  uintptr_t v = (uintptr_t)lv_obj_get_user_data(cell);
+  return v ? (uint32_t)(v - 1) : UINT32_MAX;
+}
+
+uint32_t virtual_grid_get_pool_size(lv_obj_t *cont) {
+  virtual_grid_t *vg = get_grid(cont);
+  return vg ? vg->pool_rows * vg->cfg.columns : 0;
+}
+
+lv_obj_t *virtual_grid_get_pool_cell(lv_obj_t *cont, uint32_t i) {
+  virtual_grid_t *vg = get_grid(cont);
+  if (!vg || i >= vg->pool_rows * vg->cfg.columns)
+    return nullptr;
+  return vg->cells[i];
+}
+
+lv_obj_t *virtual_grid_show_index(lv_obj_t *cont, uint32_t index) {
+  virtual_grid_t *vg = get_grid(cont);
+  if (!vg || index >= vg->cfg.count)
+    return nullptr;
+
+  uint32_t row = index / vg->cfg.columns;
+  int32_t max_scroll = (int32_t)vg->total_rows * row_pitch(vg) - vg->gap_y -
+                       lv_obj_get_content_height(cont);
+  int32_t y = row * row_pitch(vg);
+  if (y > max_scroll)
+    y = max_scroll;
+  if (y < 0)
+    y = 0;
+  lv_obj_scroll_to_y(cont, y, LV_ANIM_OFF);
+  update_window(vg);
+
+  uint32_t slot = row % vg->pool_rows;
+  return vg->cells[slot * vg->cfg.columns + index % vg->cfg.columns];
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <lvgl.h>
+
+/**
+ * Build the content of one recycled cell (called once per pooled cell)
+ */
+typedef lv_obj_t *(*virtual_grid_create_cb_t)(lv_obj_t *parent);
+
+/**
+ * Fill a pooled cell with the data of item `index`
+ * Called whenever a cell is recycled to show a different item
+ */
+typedef void (*virtual_grid_bind_cb_t)(lv_obj_t *cell, uint32_t index);
+
+struct virtual_grid_config_t {
+  uint32_t count;       // Number of items in the data source
+  uint8_t columns;      // Cells per row
+  uint8_t visible_rows; // Rows that fit the container (sets the row height)
+  uint8_t margin_rows;  // Extra rows kept bound above and below the view
+  virtual_grid_create_cb_t create_cb;
+  virtual_grid_bind_cb_t bind_cb;
+  virtual_grid_bind_cb_t unbind_cb; // Optional: cell hidden, no item to show
+};
+
+/**
+ * Turn `cont` into a virtualised grid driven by a data source
+ * Only (visible_rows + 2 * margin_rows) rows of cells are ever created; they
+ * are rebound as gridnav focus scrolls the container, so object count and
+ * LVGL heap use stay constant regardless of item count. Adds gridnav to
+ * `cont` (with rollover only when every item fits in the pool). Logs the
+ * render time of the frames drawn while it scrolls. Returns false (and
+ * leaves `cont` untouched) if the pool can't be allocated.
+ */
+bool virtual_grid_init(lv_obj_t *cont, const virtual_grid_config_t *cfg);
+
+/**
+ * Item index currently bound to a cell (UINT32_MAX if not a grid cell)
+ */
+uint32_t virtual_grid_get_index(lv_obj_t *cell);
+
+/**
+ * Number of pooled cells and access to them (e.g. for per-cell setup)
+ */
+uint32_t virtual_grid_get_pool_size(lv_obj_t *cont);
+lv_obj_t *virtual_grid_get_pool_cell(lv_obj_t *cont, uint32_t i);
+
+/**
+ * Scroll item `index` into view and return the cell now showing it
+ */
+lv_obj_t *virtual_grid_show_index(lv_obj_t *cont, uint32_t index);
@@ -0,0 +1,196 @@
+// Replays battery voltage and load traces through battery_model.cpp and
+// checks level transitions and the runtime estimate.
+// Run with: pio test -e native
+
+#include "battery_model.h"
+#include <unity.h>
+
+// Governor sample period
+#define STEP_MS 1000
+#define MINUTE_MS (60 * 1000UL)
+
+#define MAX_TRANSITIONS 16
+
+struct transition_t {
+  uint32_t at_ms;
+  battery_level_t level;
+};
+
+struct replay_t {
+  battery_filter_t filter;
+  battery_level_t level;
+  uint32_t filtered_mv;
+  transition_t seen[MAX_TRANSITIONS];
+  uint32_t count;
+};
+
+// Block mean at `t` ms into a trace
+typedef uint32_t (*trace_fn_t)(uint32_t t);
+
+// Deterministic ripple of +-amp mV (radio and SPI load on the rail)
+static int32_t ripple(uint32_t t, int32_t amp) {
+  uint32_t x = t * 2654435761u;
+  x ^= x >> 15;
+  return (int32_t)(x % (2 * amp + 1)) - amp;
+}
+
+static void replay_init(replay_t *r) {
+  battery_filter_init(&r->filter);
+  r->level = BATTERY_EXTERNAL; // What the governor starts with
+  r->filtered_mv = 0;
+  r->count = 0;
+}
+
+// Feed samples for [from, to) ms of the trace, starting the clock at `start`
+static void replay(replay_t *r, uint32_t start, uint32_t from, uint32_t to,
+                   trace_fn_t trace) {
+  for (uint32_t t = from; t < to; t += STEP_MS) {
+    float mv = battery_filter_step(&r->filter, trace(t), start + t);
+    r->filtered_mv = (uint32_t)(mv + 0.5f);
+    battery_level_t next = battery_level_step(r->level, r->filtered_mv);
+    if (next != r->level && r->count < MAX_TRANSITIONS)
+      r->seen[r->count++] = {t, next};
+    r->level = next;
+  }
+}
+
+static void check_transition(const replay_t *r, uint32_t i,
+                             battery_level_t level, uint32_t at_ms,
+                             uint32_t within_ms) {
+  TEST_ASSERT_GREATER_THAN_UINT32(i, r->count);
+  TEST_ASSERT_EQUAL(level, r->seen[i].level);
+  TEST_ASSERT_UINT32_WITHIN(within_ms, at_ms, r->seen[i].at_ms);
+}
+
+// 3800 mV falling 5 mV a minute for 50 minutes: 20% charge is crossed at
+// 3672 mV (25.6 min), 8% below 3600 mV (40 min)
+static uint32_t discharge(uint32_t t) {
+  return 3800 - t / 12000 + ripple(t, 15);
+}
+
+// Dropping onto the low threshold, then recovering under a lighter load
+static uint32_t hover(uint32_t t) {
+  uint32_t base = t < 5 * MINUTE_MS    ? 3700  // 26%
+                  : t < 15 * MINUTE_MS ? 3670  // 19%
+                  : t < 25 * MINUTE_MS ? 3680  // 21%, inside the hysteresis
+                                       : 3700; // 26%
+  return base + ripple(t, 20);
+}
+
+// On battery, USB plugged in at 2 min and removed at 4 min
+static uint32_t usb(uint32_t t) {
+  bool plugged = t >= 2 * MINUTE_MS && t < 4 * MINUTE_MS;
+  return (plugged ? 4450 : 3800) + ripple(t, 10);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_block_mean_ignores_spikes() {
+  uint16_t mv[64];
+  for (int i = 0; i < 64; i++)
+    mv[i] = 3700 + (i % 5);
+  // Dips from radio bursts and a few high readings
+  for (int i = 0; i < 12; i++)
+    mv[i * 5] = i % 3 ? 3200 : 4100;
+  uint32_t mean = battery_block_mv(mv, 64);
+  TEST_ASSERT_UINT32_WITHIN(3, 3702, mean);
+  TEST_ASSERT_EQUAL_UINT32(0, battery_block_mv(mv, 0));
+}
+
+void test_discharge_trace() {
+  replay_t r;
+  replay_init(&r);
+  replay(&r, 0, 0, 50 * MINUTE_MS, discharge);
+  TEST_ASSERT_EQUAL_UINT32(3, r.count);
+  check_transition(&r, 0, BATTERY_NORMAL, 0, 0);
+  check_transition(&r, 1, BATTERY_LOW, 25.6 * MINUTE_MS, MINUTE_MS);
+  check_transition(&r, 2, BATTERY_CRITICAL, 40 * MINUTE_MS, MINUTE_MS);
+}
+
+void test_discharge_trace_across_millis_wrap() {
+  replay_t r;
+  replay_init(&r);
+  replay(&r, UINT32_MAX - 30 * MINUTE_MS, 0, 50 * MINUTE_MS, discharge);
+  TEST_ASSERT_EQUAL_UINT32(3, r.count);
+  check_transition(&r, 1, BATTERY_LOW, 25.6 * MINUTE_MS, MINUTE_MS);
+  check_transition(&r, 2, BATTERY_CRITICAL, 40 * MINUTE_MS, MINUTE_MS);
+}
+
+void test_hysteresis_holds_level() {
+  replay_t r;
+  replay_init(&r);
+  replay(&r, 0, 0, 35 * MINUTE_MS, hover);
+  // Low once despite the ripple, normal again only past the hysteresis
+  TEST_ASSERT_EQUAL_UINT32(3, r.count);
+  check_transition(&r, 0, BATTERY_NORMAL, 0, 0);
+  check_transition(&r, 1, BATTERY_LOW, 5 * MINUTE_MS, MINUTE_MS);
+  check_transition(&r, 2, BATTERY_NORMAL, 25 * MINUTE_MS, MINUTE_MS);
+}
+
+void test_usb_plug_bypasses_filter() {
+  replay_t r;
+  replay_init(&r);
+  replay(&r, 0, 0, 6 * MINUTE_MS, usb);
+  TEST_ASSERT_EQUAL_UINT32(3, r.count);
+  check_transition(&r, 0, BATTERY_NORMAL, 0, 0);
+  // The jump restarts the filter, so the change is seen on the next sample
+  check_transition(&r, 1, BATTERY_EXTERNAL, 2 * MINUTE_MS, 0);
+  check_transition(&r, 2, BATTERY_NORMAL, 4 * MINUTE_MS, 0);
+  TEST_ASSERT_UINT32_WITHIN(15, 3800, r.filtered_mv);
+}
+
+void test_runtime_estimate_for_mixed_use() {
+  // One minute awake at brightness 200, four asleep polling every 100 ms,
+  // accounted every 10 ms loop pass / once per wake like the governor
+  battery_energy_t e;
+  battery_energy_init(&e);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX,
+                           battery_runtime_min(50, battery_energy_avg_ma(&e)));
+
+  battery_load_t active = {BATTERY_STATE_ACTIVE, 200, 100};
+  battery_load_t sleep = {BATTERY_STATE_SLEEP, 0, 100};
+  for (int cycle = 0; cycle < 12; cycle++) {
+    for (uint32_t t = 0; t < MINUTE_MS; t += 10)
+      battery_energy_account(&e, &active, 10);
+    battery_energy_account(&e, &sleep, 4 * MINUTE_MS);
+  }
+  float active_ma = BATTERY_ACTIVE_MA + BATTERY_DISPLAY_MA * 200 / 255.0f;
+  float sleep_ma = BATTERY_SLEEP_MA + BATTERY_POLL_MAS * 1000.0f / 100;
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, active_ma, battery_load_ma(&active));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, sleep_ma, battery_load_ma(&sleep));
+
+  // Ending on a sleep stretch the recent-weighted average is under the
+  // plain 1:4 mix (24.7 mA): the 4 min of sleep count in full, the active
+  // minute before it decays to 10 * (1 - e^-0.1) * e^-0.4 = 0.64 min
+  float avg = battery_energy_avg_ma(&e);
+  float mix = (active_ma + 4 * sleep_ma) / 5;
+  float expect = (4 * sleep_ma + 0.638f * active_ma) / 4.638f;
+  TEST_ASSERT_TRUE(avg < mix);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, expect, avg);
+
+  // 48% of 500 mAh at ~18 mA: about 13 hours
+  uint8_t soc = battery_soc_pct(3800);
+  TEST_ASSERT_EQUAL_UINT8(48, soc);
+  uint32_t minutes = battery_runtime_min(soc, avg);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)(240.0f / avg * 60.0f), minutes);
+  TEST_ASSERT_UINT32_WITHIN(5, 800, minutes);
+
+  // An hour of sleep only: older load has faded and the estimate follows
+  battery_energy_account(&e, &sleep, 60 * MINUTE_MS);
+  avg = battery_energy_avg_ma(&e);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, sleep_ma, avg);
+  TEST_ASSERT_UINT32_WITHIN(60, (uint32_t)(240.0f / sleep_ma * 60.0f),
+                            battery_runtime_min(soc, avg));
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_block_mean_ignores_spikes);
+  RUN_TEST(test_discharge_trace);
+  RUN_TEST(test_discharge_trace_across_millis_wrap);
+  RUN_TEST(test_hysteresis_holds_level);
+  RUN_TEST(test_usb_plug_bypasses_filter);
+  RUN_TEST(test_runtime_estimate_for_mixed_use);
+  return UNITY_END();
+}
@@ -0,0 +1,201 @@
+// Round trips key and delta frames through fb_codec.cpp's encoder and a
+// decoder written from the format in fb_codec.h (as tools/fb_capture.py
+// reads it). Run with: pio test -e native
+
+#include "fb_codec.h"
+#include <string.h>
+#include <unity.h>
+
+#define FB_W 96
+#define FB_H 40
+#define OUT_CAP (FB_W * FB_H * 2 * 2)
+
+static uint16_t frame_a[FB_W * FB_H];
+static uint16_t frame_b[FB_W * FB_H];
+static uint16_t decoded[FB_W * FB_H];
+static uint8_t out[OUT_CAP];
+
+static uint32_t get_varint(const uint8_t *p, size_t len, size_t *pos) {
+  uint32_t v = 0;
+  for (int shift = 0; *pos < len; shift += 7) {
+    uint8_t b = p[(*pos)++];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      return v;
+  }
+  TEST_FAIL_MESSAGE("varint runs past the payload");
+  return 0;
+}
+
+static uint16_t get_pixel(const uint8_t *p, size_t *pos) {
+  uint16_t px;
+  memcpy(&px, p + *pos, sizeof(px));
+  *pos += sizeof(px);
+  return px;
+}
+
+// Apply a payload to the w x h area at (x, y) of `fb`; every row must be
+// covered exactly. Returns the number of skip tokens seen.
+static uint32_t decode_area(uint16_t *fb, uint16_t x, uint16_t y, uint16_t w,
+                            uint16_t h, const uint8_t *p, size_t len) {
+  size_t pos = 0;
+  uint32_t skips = 0;
+  for (uint16_t row = 0; row < h; row++) {
+    uint16_t *dst = fb + (y + row) * FB_W + x;
+    uint32_t col = 0;
+    while (col < w) {
+      TEST_ASSERT_TRUE(pos < len);
+      uint8_t token = p[pos++];
+      uint32_t n = get_varint(p, len, &pos);
+      TEST_ASSERT_TRUE(n > 0 && col + n <= w);
+      if (token == FB_TOKEN_SKIP) {
+        skips++;
+      } else if (token == FB_TOKEN_RUN) {
+        uint16_t px = get_pixel(p, &pos);
+        for (uint32_t i = 0; i < n; i++)
+          dst[col + i] = px;
+      } else {
+        TEST_ASSERT_EQUAL_UINT8(FB_TOKEN_LITERAL, token);
+        for (uint32_t i = 0; i < n; i++)
+          dst[col + i] = get_pixel(p, &pos);
+      }
+      col += n;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(len, pos);
+  return skips;
+}
+
+// A UI-like frame: flat background, a gradient bar, noise-ish text pixels
+static void draw(uint16_t *fb, uint32_t seed) {
+  for (int y = 0; y < FB_H; y++) {
+    for (int x = 0; x < FB_W; x++) {
+      uint16_t px = 0x0841;
+      if (y >= 4 && y < 10)
+        px = (uint16_t)(x * 0x0421);
+      if (y >= 20 && y < 28 && x >= 10 && x < 70) {
+        uint32_t h = (x * 31 + y * 17 + seed) * 2654435761u;
+        px = (h >> 28) & 1 ? 0xFFFF : 0x0841;
+      }
+      fb[y * FB_W + x] = px;
+    }
+  }
+}
+
+static void assert_area_equal(const uint16_t *expect, const uint16_t *got,
+                              uint16_t x, uint16_t y, uint16_t w,
+                              uint16_t h) {
+  for (uint16_t row = y; row < y + h; row++)
+    TEST_ASSERT_EQUAL_MEMORY(expect + row * FB_W + x, got + row * FB_W + x,
+                             w * sizeof(uint16_t));
+}
+
+void setUp() {
+  draw(frame_a, 1);
+  memset(decoded, 0xAA, sizeof(decoded));
+}
+void tearDown() {}
+
+void test_key_frame_round_trip() {
+  size_t len =
+      fb_encode_area(frame_a, FB_W, NULL, 0, FB_W, FB_H, out, sizeof(out));
+  TEST_ASSERT_TRUE(len > 0);
+  // Flat rows compress to a run each
+  TEST_ASSERT_TRUE(len < sizeof(frame_a) / 2);
+  TEST_ASSERT_EQUAL_UINT32(0,
+                           decode_area(decoded, 0, 0, FB_W, FB_H, out, len));
+  assert_area_equal(frame_a, decoded, 0, 0, FB_W, FB_H);
+}
+
+void test_partial_area_uses_stride() {
+  // A flushed stripe in the middle of the screen
+  const uint16_t x = 7, y = 18, w = 60, h = 12;
+  const uint16_t *src = frame_a + y * FB_W + x;
+  size_t len = fb_encode_area(src, FB_W, NULL, 0, w, h, out, sizeof(out));
+  TEST_ASSERT_TRUE(len > 0);
+  decode_area(decoded, x, y, w, h, out, len);
+  assert_area_equal(frame_a, decoded, x, y, w, h);
+}
+
+void test_delta_frame_round_trip() {
+  // The host holds frame A; frame B changes the text block only
+  memcpy(decoded, frame_a, sizeof(decoded));
+  draw(frame_b, 2);
+  size_t len = fb_encode_area(frame_b, FB_W, frame_a, FB_W, FB_W, FB_H, out,
+                              sizeof(out));
+  TEST_ASSERT_TRUE(len > 0);
+  TEST_ASSERT_TRUE(decode_area(decoded, 0, 0, FB_W, FB_H, out, len) > 0);
+  assert_area_equal(frame_b, decoded, 0, 0, FB_W, FB_H);
+
+  size_t key_len =
+      fb_encode_area(frame_b, FB_W, NULL, 0, FB_W, FB_H, out, sizeof(out));
+  TEST_ASSERT_TRUE(len < key_len);
+}
+
+void test_unchanged_frame_is_all_skips() {
+  size_t len = fb_encode_area(frame_a, FB_W, frame_a, FB_W, FB_W, FB_H, out,
+                              sizeof(out));
+  // One skip token (type + 1-byte varint) per row
+  TEST_ASSERT_EQUAL_UINT32(FB_H * 2, len);
+  memcpy(decoded, frame_a, sizeof(decoded));
+  TEST_ASSERT_EQUAL_UINT32(FB_H,
+                           decode_area(decoded, 0, 0, FB_W, FB_H, out, len));
+  assert_area_equal(frame_a, decoded, 0, 0, FB_W, FB_H);
+}
+
+void test_long_run_uses_multibyte_varint() {
+  static uint16_t wide[300];
+  for (int i = 0; i < 300; i++)
+    wide[i] = 0xF800;
+  size_t len = fb_encode_area(wide, 300, NULL, 0, 300, 1, out, sizeof(out));
+  // RUN, varint 300 (two bytes), one pixel
+  TEST_ASSERT_EQUAL_UINT32(1 + 2 + 2, len);
+  TEST_ASSERT_EQUAL_HEX8(FB_TOKEN_RUN, out[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x80 | (300 & 0x7F), out[1]);
+  TEST_ASSERT_EQUAL_HEX8(300 >> 7, out[2]);
+}
+
+void test_frame_too_big_for_buffer() {
+  // Noise doesn't compress: the payload is larger than the raw pixels
+  for (int i = 0; i < FB_W * FB_H; i++)
+    frame_b[i] = (uint16_t)(i * 40503u);
+  size_t need =
+      fb_encode_area(frame_b, FB_W, NULL, 0, FB_W, FB_H, out, sizeof(out));
+  TEST_ASSERT_TRUE(need > sizeof(frame_b));
+  TEST_ASSERT_EQUAL_UINT32(
+      0, fb_encode_area(frame_b, FB_W, NULL, 0, FB_W, FB_H, out, need - 1));
+  TEST_ASSERT_EQUAL_UINT32(
+      0, fb_encode_area(frame_b, FB_W, NULL, 0, FB_W, FB_H, out, 16));
+  TEST_ASSERT_EQUAL_UINT32(need, fb_encode_area(frame_b, FB_W, NULL, 0, FB_W,
+                                                FB_H, out, need));
+}
+
+void test_header_checksums() {
+  static const uint8_t abcde[] = {'a', 'b', 'c', 'd', 'e'};
+  TEST_ASSERT_EQUAL_HEX32(0xC8F0, fb_fletcher16(abcde, sizeof(abcde)));
+
+  size_t len =
+      fb_encode_area(frame_a, FB_W, NULL, 0, FB_W, FB_H, out, sizeof(out));
+  fb_packet_header_t hdr;
+  fb_fill_header(&hdr, FB_PACKET_AREA, FB_FLAG_KEY, 42, 0, 0, FB_W, FB_H, out,
+                 len);
+  TEST_ASSERT_EQUAL_UINT32(24, sizeof(hdr));
+  TEST_ASSERT_EQUAL_UINT8('F', hdr.magic[0]);
+  TEST_ASSERT_EQUAL_UINT8('B', hdr.magic[1]);
+  TEST_ASSERT_EQUAL_UINT32(len, hdr.length);
+  TEST_ASSERT_EQUAL_HEX32(fb_fletcher16(out, len), hdr.payload_sum);
+  TEST_ASSERT_EQUAL_HEX32(
+      fb_fletcher16((const uint8_t *)&hdr, sizeof(hdr) - 2), hdr.header_sum);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_key_frame_round_trip);
+  RUN_TEST(test_partial_area_uses_stride);
+  RUN_TEST(test_delta_frame_round_trip);
+  RUN_TEST(test_unchanged_frame_is_all_skips);
+  RUN_TEST(test_long_run_uses_multibyte_varint);
+  RUN_TEST(test_frame_too_big_for_buffer);
+  RUN_TEST(test_header_checksums);
+  return UNITY_END();
+}
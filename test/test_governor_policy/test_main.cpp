@@ -0,0 +1,147 @@
+// Replays input/animation/fade traces through governor_policy.cpp and
+// checks when the profile changes. Run with: pio test -e native
+
+#include "governor_policy.h"
+#include <unity.h>
+
+// Main-loop pass interval the trace is sampled at
+#define STEP_MS 10
+
+enum activity_t { ACT_INPUT, ACT_ANIM, ACT_FADE };
+
+// Activity of one kind during [start_ms, end_ms); a single pass if equal
+struct trace_event_t {
+  uint32_t start_ms;
+  uint32_t end_ms;
+  activity_t kind;
+};
+
+struct transition_t {
+  uint32_t at_ms;
+  perf_profile_t profile;
+};
+
+#define MAX_TRANSITIONS 32
+
+struct replay_t {
+  governor_policy_t policy;
+  transition_t seen[MAX_TRANSITIONS];
+  uint32_t count;
+};
+
+static bool active(const trace_event_t *ev, uint32_t t) {
+  if (ev->start_ms == ev->end_ms)
+    return t == ev->start_ms;
+  return t - ev->start_ms < ev->end_ms - ev->start_ms;
+}
+
+// Feed one sample per loop pass from `start` for `duration` ms; trace times
+// are relative to `start` so the same trace can run across a millis() wrap
+static void replay(replay_t *r, uint32_t start, uint32_t duration,
+                   const trace_event_t *trace, uint32_t n) {
+  governor_policy_init(&r->policy, start);
+  r->count = 0;
+  for (uint32_t t = 0; t <= duration; t += STEP_MS) {
+    governor_sample_t s = {};
+    s.now_ms = start + t;
+    for (uint32_t i = 0; i < n; i++) {
+      if (!active(&trace[i], t))
+        continue;
+      s.input |= trace[i].kind == ACT_INPUT;
+      s.animating |= trace[i].kind == ACT_ANIM;
+      s.fading |= trace[i].kind == ACT_FADE;
+    }
+    if (governor_policy_step(&r->policy, &s) && r->count < MAX_TRANSITIONS)
+      r->seen[r->count++] = {t, r->policy.profile};
+  }
+}
+
+static void check_transitions(const replay_t *r, const transition_t *expect,
+                              uint32_t n) {
+  TEST_ASSERT_EQUAL_UINT32(n, r->count);
+  TEST_ASSERT_EQUAL_UINT32(n, r->policy.switches);
+  for (uint32_t i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_UINT32(expect[i].at_ms, r->seen[i].at_ms);
+    TEST_ASSERT_EQUAL(expect[i].profile, r->seen[i].profile);
+  }
+}
+
+// Trackball scrolling, a brightness fade, an animation with a short pause
+// and input arriving just inside the hold time
+static const trace_event_t session[] = {
+    {100, 100, ACT_INPUT},     {300, 300, ACT_INPUT},
+    {500, 500, ACT_INPUT},     {4000, 4600, ACT_FADE},
+    {8000, 8300, ACT_ANIM},    {9000, 9000, ACT_INPUT},
+    {12000, 12000, ACT_INPUT}, {13500, 13500, ACT_INPUT},
+    {15000, 15000, ACT_INPUT}, {16500, 16500, ACT_INPUT},
+    {18000, 18000, ACT_INPUT}, {19500, 19500, ACT_INPUT},
+};
+
+static const transition_t session_expect[] = {
+    {500 + GOVERNOR_QUIET_AFTER_MS, PROFILE_QUIET},
+    {4000, PROFILE_PERFORMANCE},
+    {4590 + GOVERNOR_QUIET_AFTER_MS, PROFILE_QUIET},
+    {8000, PROFILE_PERFORMANCE},
+    {9000 + GOVERNOR_QUIET_AFTER_MS, PROFILE_QUIET},
+    {12000, PROFILE_PERFORMANCE},
+    {19500 + GOVERNOR_QUIET_AFTER_MS, PROFILE_QUIET},
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_starts_in_performance() {
+  governor_policy_t p;
+  governor_policy_init(&p, 1234);
+  TEST_ASSERT_EQUAL(PROFILE_PERFORMANCE, p.profile);
+  TEST_ASSERT_EQUAL_UINT32(0, p.switches);
+}
+
+void test_quiet_needs_full_hold_time() {
+  governor_policy_t p;
+  governor_policy_init(&p, 0);
+  governor_sample_t s = {};
+  s.now_ms = GOVERNOR_QUIET_AFTER_MS - 1;
+  TEST_ASSERT_FALSE(governor_policy_step(&p, &s));
+  TEST_ASSERT_EQUAL(PROFILE_PERFORMANCE, p.profile);
+  s.now_ms = GOVERNOR_QUIET_AFTER_MS;
+  TEST_ASSERT_TRUE(governor_policy_step(&p, &s));
+  TEST_ASSERT_EQUAL(PROFILE_QUIET, p.profile);
+  // Staying quiet is not another switch
+  s.now_ms += 5000;
+  TEST_ASSERT_FALSE(governor_policy_step(&p, &s));
+}
+
+void test_session_trace() {
+  replay_t r;
+  replay(&r, 0, 25000, session, sizeof(session) / sizeof(session[0]));
+  check_transitions(&r, session_expect,
+                    sizeof(session_expect) / sizeof(session_expect[0]));
+}
+
+void test_session_trace_across_millis_wrap() {
+  replay_t r;
+  replay(&r, UINT32_MAX - 10000, 25000, session,
+         sizeof(session) / sizeof(session[0]));
+  check_transitions(&r, session_expect,
+                    sizeof(session_expect) / sizeof(session_expect[0]));
+}
+
+void test_continuous_fade_holds_performance() {
+  static const trace_event_t fade[] = {{0, 10000, ACT_FADE}};
+  static const transition_t expect[] = {
+      {9990 + GOVERNOR_QUIET_AFTER_MS, PROFILE_QUIET}};
+  replay_t r;
+  replay(&r, 0, 15000, fade, 1);
+  check_transitions(&r, expect, 1);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_starts_in_performance);
+  RUN_TEST(test_quiet_needs_full_hold_time);
+  RUN_TEST(test_session_trace);
+  RUN_TEST(test_session_trace_across_millis_wrap);
+  RUN_TEST(test_continuous_fade_holds_performance);
+  return UNITY_END();
+}
@@ -0,0 +1,218 @@
+// Frame generation and I2C write planning of led_effects.cpp.
+// Run with: pio test -e native
+
+#include "led_effects.h"
+#include <unity.h>
+
+static const led_rgbw_t OFF = {{0, 0, 0, 0}};
+static const led_rgbw_t RED = {{255, 0, 0, 0}};
+static const led_rgbw_t BLUE = {{0, 0, 200, 0}};
+static const led_rgbw_t WHITE = {{255, 255, 255, 255}};
+
+static void assert_color(const led_rgbw_t &expect, const led_rgbw_t &got) {
+  for (int i = 0; i < LED_CHANNELS; i++)
+    TEST_ASSERT_EQUAL_UINT8(expect.c[i], got.c[i]);
+}
+
+static led_rgbw_t mix_half(const led_rgbw_t &a, const led_rgbw_t &b) {
+  led_rgbw_t out;
+  for (int i = 0; i < LED_CHANNELS; i++)
+    out.c[i] = (uint8_t)((a.c[i] + b.c[i]) / 2);
+  return out;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_solid_is_static() {
+  led_effects_t fx;
+  led_effects_init(&fx, BLUE);
+  assert_color(BLUE, led_effects_frame(&fx, 0));
+  assert_color(BLUE, led_effects_frame(&fx, 100000));
+  TEST_ASSERT_FALSE(led_effects_animating(&fx));
+}
+
+void test_transition_fades_and_settles() {
+  led_effects_t fx;
+  led_effects_init(&fx, OFF);
+  led_effects_transition(&fx, RED, 1000, 400);
+  TEST_ASSERT_TRUE(led_effects_animating(&fx));
+
+  assert_color(OFF, led_effects_frame(&fx, 1000));
+  TEST_ASSERT_UINT32_WITHIN(2, 127, led_effects_frame(&fx, 1200).c[LED_R]);
+  uint8_t prev = 0;
+  for (uint32_t t = 1000; t < 1400; t += 20) {
+    uint8_t r = led_effects_frame(&fx, t).c[LED_R];
+    TEST_ASSERT_GREATER_OR_EQUAL(prev, r);
+    prev = r;
+  }
+  assert_color(RED, led_effects_frame(&fx, 1400));
+  TEST_ASSERT_FALSE(led_effects_animating(&fx));
+}
+
+void test_transition_retarget_starts_from_shown_colour() {
+  led_effects_t fx;
+  led_effects_init(&fx, OFF);
+  led_effects_transition(&fx, RED, 0, 400);
+  led_rgbw_t mid = led_effects_frame(&fx, 200);
+  led_effects_transition(&fx, BLUE, 200, 400);
+  assert_color(mid, led_effects_frame(&fx, 200));
+  assert_color(BLUE, led_effects_frame(&fx, 600));
+}
+
+void test_pulse_peaks_and_returns() {
+  led_effects_t fx;
+  led_effects_init(&fx, BLUE);
+  led_effects_pulse(&fx, WHITE, 0, 600);
+  assert_color(BLUE, led_effects_frame(&fx, 0));
+  assert_color(WHITE, led_effects_frame(&fx, 300));
+  assert_color(BLUE, led_effects_frame(&fx, 600));
+  TEST_ASSERT_FALSE(led_effects_animating(&fx));
+
+  // A pulse restarted mid-way still comes back to the original colour
+  led_effects_pulse(&fx, WHITE, 1000, 600);
+  led_effects_frame(&fx, 1200);
+  led_effects_pulse(&fx, RED, 1200, 600);
+  assert_color(BLUE, led_effects_frame(&fx, 1800));
+}
+
+void test_breathe_repeats() {
+  led_effects_t fx;
+  led_effects_init(&fx, OFF);
+  led_effects_breathe(&fx, RED, 0, 2000);
+  for (uint32_t cycle = 0; cycle < 3; cycle++) {
+    assert_color(OFF, led_effects_frame(&fx, cycle * 2000));
+    assert_color(RED, led_effects_frame(&fx, cycle * 2000 + 1000));
+  }
+  TEST_ASSERT_TRUE(led_effects_animating(&fx));
+}
+
+void test_flash_overrides_then_reverts() {
+  led_effects_t fx;
+  led_effects_init(&fx, BLUE);
+  led_effects_flash(&fx, WHITE, 500, 80);
+  assert_color(WHITE, led_effects_frame(&fx, 500));
+  assert_color(WHITE, led_effects_frame(&fx, 579));
+  assert_color(BLUE, led_effects_frame(&fx, 580));
+  TEST_ASSERT_FALSE(led_effects_animating(&fx));
+}
+
+void test_transition_after_flash_starts_from_base() {
+  // ENTER flashes white, then the click picks a new colour
+  led_effects_t fx;
+  led_effects_init(&fx, BLUE);
+  led_effects_flash(&fx, WHITE, 0, 80);
+  assert_color(WHITE, led_effects_frame(&fx, 10));
+  led_effects_transition(&fx, RED, 20, 400);
+  // The flash still shows until it ends, the fade underneath is from blue
+  assert_color(WHITE, led_effects_frame(&fx, 20));
+  assert_color(mix_half(BLUE, RED), led_effects_frame(&fx, 220));
+  assert_color(RED, led_effects_frame(&fx, 420));
+}
+
+void test_writer_first_write_is_full() {
+  led_writer_t w;
+  led_write_t out;
+  led_writer_init(&w, 25, 0);
+  TEST_ASSERT_TRUE(led_writer_plan(&w, &OFF, 0, &out));
+  TEST_ASSERT_EQUAL_UINT8(0, out.first);
+  TEST_ASSERT_EQUAL_UINT8(LED_CHANNELS, out.count);
+}
+
+void test_writer_skips_identical_frames() {
+  led_writer_t w;
+  led_write_t out;
+  led_writer_init(&w, 25, 0);
+  led_writer_plan(&w, &BLUE, 0, &out);
+  for (uint32_t t = 20; t <= 1000; t += 20)
+    TEST_ASSERT_FALSE(led_writer_plan(&w, &BLUE, t, &out));
+  TEST_ASSERT_EQUAL_UINT32(1, w.writes);
+  TEST_ASSERT_EQUAL_UINT32(50, w.skipped_same);
+  TEST_ASSERT_EQUAL_UINT32(0, w.skipped_budget);
+}
+
+void test_writer_sends_changed_span_only() {
+  led_writer_t w;
+  led_write_t out;
+  led_writer_init(&w, 25, 0);
+  led_writer_plan(&w, &OFF, 0, &out);
+
+  led_rgbw_t g = {{0, 7, 0, 0}};
+  TEST_ASSERT_TRUE(led_writer_plan(&w, &g, 1000, &out));
+  TEST_ASSERT_EQUAL_UINT8(LED_G, out.first);
+  TEST_ASSERT_EQUAL_UINT8(1, out.count);
+  TEST_ASSERT_EQUAL_UINT8(7, out.values[0]);
+
+  // R and W changed: one write over R..W rather than two
+  led_rgbw_t rw = {{9, 7, 0, 9}};
+  TEST_ASSERT_TRUE(led_writer_plan(&w, &rw, 2000, &out));
+  TEST_ASSERT_EQUAL_UINT8(LED_R, out.first);
+  TEST_ASSERT_EQUAL_UINT8(LED_CHANNELS, out.count);
+  // Register byte plus payload per write
+  TEST_ASSERT_EQUAL_UINT32((1 + 4) + (1 + 1) + (1 + 4), w.bytes);
+}
+
+void test_writer_budget_limits_rate() {
+  led_writer_t w;
+  led_write_t out;
+  led_writer_init(&w, 25, 0);
+
+  // Every frame differs: a burst, then 25 writes per second
+  led_rgbw_t frame = OFF;
+  for (uint32_t t = 0; t < 2000; t += 5) {
+    frame.c[LED_B] = (uint8_t)(t / 5);
+    led_writer_plan(&w, &frame, t, &out);
+  }
+  TEST_ASSERT_UINT32_WITHIN(1, LED_WRITER_BURST + 2 * 25, w.writes);
+  TEST_ASSERT_EQUAL_UINT32(w.frames, w.writes + w.skipped_budget);
+}
+
+void test_writer_long_idle_refill_is_capped() {
+  led_writer_t w;
+  led_write_t out;
+  led_writer_init(&w, 25, 0);
+  led_rgbw_t frame = OFF;
+  uint32_t t = 0xFFFFF000; // Idle across a millis() wrap
+  uint32_t sent = 0;
+  for (int i = 0; i < 10; i++) {
+    frame.c[LED_R] = (uint8_t)(i + 1);
+    sent += led_writer_plan(&w, &frame, t, &out);
+  }
+  TEST_ASSERT_EQUAL_UINT32(LED_WRITER_BURST, sent);
+}
+
+void test_effect_frames_through_writer() {
+  // 20 ms frames of a 1 s transition: the budget, not the frame rate,
+  // sets the write count and the final colour always gets out
+  led_effects_t fx;
+  led_writer_t w;
+  led_write_t out;
+  led_effects_init(&fx, OFF);
+  led_writer_init(&w, 25, 0);
+  led_effects_transition(&fx, WHITE, 0, 1000);
+  for (uint32_t t = 0; t <= 1500; t += 20) {
+    led_rgbw_t f = led_effects_frame(&fx, t);
+    led_writer_plan(&w, &f, t, &out);
+  }
+  assert_color(WHITE, w.sent);
+  TEST_ASSERT_LESS_OR_EQUAL(LED_WRITER_BURST + 38, w.writes);
+  TEST_ASSERT_GREATER_THAN(0, w.skipped_same);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_solid_is_static);
+  RUN_TEST(test_transition_fades_and_settles);
+  RUN_TEST(test_transition_retarget_starts_from_shown_colour);
+  RUN_TEST(test_pulse_peaks_and_returns);
+  RUN_TEST(test_breathe_repeats);
+  RUN_TEST(test_flash_overrides_then_reverts);
+  RUN_TEST(test_transition_after_flash_starts_from_base);
+  RUN_TEST(test_writer_first_write_is_full);
+  RUN_TEST(test_writer_skips_identical_frames);
+  RUN_TEST(test_writer_sends_changed_span_only);
+  RUN_TEST(test_writer_budget_limits_rate);
+  RUN_TEST(test_writer_long_idle_refill_is_capped);
+  RUN_TEST(test_effect_frames_through_writer);
+  return UNITY_END();
+}
@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+"""Capture the AMOLED contents over USB CDC and rebuild them as PNG frames.
+
+Sends "capture on" to the firmware, decodes the delta/RLE area packets it
+streams from disp_flush, and writes one PNG per refreshed frame. Device log
+lines that arrive between packets are echoed to stderr.
+
+Example:
+  python tools/fb_capture.py --port /dev/ttyACM0 -o frames/
+  python tools/fb_capture.py --port /dev/ttyACM0 --record cap.bin --frames 100
+  python tools/fb_capture.py --input cap.bin -o frames/
+
+Per-frame bandwidth and the encode time added to flush are printed for
+every frame, with a summary at the end. With --port a corrupted packet
+makes it send "capture key" (at most once a second) so the stream
+resynchronises on a fresh key frame. Needs pyserial for --port.
+The packet layout must match src/fb_codec.h.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+WIDTH = 536
+HEIGHT = 240
+
+MAGIC = b"FB"
+PACKET_AREA = 1
+PACKET_FRAME_END = 2
+FLAG_KEY = 0x01
+
+TOKEN_SKIP = 0
+TOKEN_RUN = 1
+TOKEN_LITERAL = 2
+
+HEADER = struct.Struct("<2sBBIHHHHIHH")
+STATS = struct.Struct("<IIIIII")
+# Sanity limit so a corrupted length can't stall the parser
+MAX_PAYLOAD = 512 * 1024
+# Minimum spacing of "capture key" requests while out of sync
+KEY_REQUEST_INTERVAL_S = 1.0
+
+
+def fletcher16(data):
+    a = b = 0
+    for i in range(0, len(data), 4096):
+        for byte in data[i:i + 4096]:
+            a += byte
+            b += a
+        a %= 255
+        b %= 255
+    return (b << 8) | a
+
+
+def read_varint(buf, pos):
+    value = shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def decode_area(payload, canvas, x0, y0, w, h):
+    """Paint an area payload onto canvas (list of RGB565 ints, row-major)."""
+    pos = 0
+    i = 0
+    total = w * h
+    while i < total:
+        token = payload[pos]
+        count, pos = read_varint(payload, pos + 1)
+        if token == TOKEN_SKIP:
+            i += count
+            continue
+        if token == TOKEN_RUN:
+            (px,) = struct.unpack_from("<H", payload, pos)
+            pos += 2
+            pixels = [px] * count
+        elif token == TOKEN_LITERAL:
+            pixels = list(struct.unpack_from("<%dH" % count, payload, pos))
+            pos += 2 * count
+        else:
+            raise ValueError("bad token %d" % token)
+        for px in pixels:
+            row, col = divmod(i, w)
+            canvas[(y0 + row) * WIDTH + x0 + col] = px
+            i += 1
+    if pos != len(payload):
+        raise ValueError("payload has %d trailing bytes" % (len(payload) - pos))
+
+
+def write_png(path, canvas, swap):
+    rows = bytearray()
+    for y in range(HEIGHT):
+        rows.append(0)  # Filter: none
+        for px in canvas[y * WIDTH:(y + 1) * WIDTH]:
+            if swap:
+                px = ((px & 0xFF) << 8) | (px >> 8)
+            r = (px >> 11) & 0x1F
+            g = (px >> 5) & 0x3F
+            b = px & 0x1F
+            rows += bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4),
+                           (b << 3) | (b >> 2)))
+
+    def chunk(kind, data):
+        body = kind + data
+        return (struct.pack(">I", len(data)) + body +
+                struct.pack(">I", zlib.crc32(body) & 0xFFFFFFFF))
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", WIDTH, HEIGHT, 8, 2,
+                                           0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(bytes(rows), 6)))
+        f.write(chunk(b"IEND", b""))
+
+
+class Decoder:
+    def __init__(self, outdir, swap, request_key=None):
+        self.outdir = outdir
+        self.swap = swap
+        self.request_key = request_key  # Called to ask for a key frame
+        self.last_key_request = None
+        self.key_requests = 0
+        self.buf = bytearray()
+        self.canvas = [0] * (WIDTH * HEIGHT)
+        self.synced = False  # Canvas valid (a key frame has been seen)
+        self.frames = 0
+        self.bad = 0
+        self.totals = [0, 0, 0, 0]  # bytes, raw, encode_us, push_us
+        self.dropped = 0
+        self.log = bytearray()
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                # Keep a possible partial magic byte
+                keep = 1 if self.buf.endswith(MAGIC[:1]) else 0
+                self.echo(self.buf[:len(self.buf) - keep])
+                del self.buf[:len(self.buf) - keep]
+                return
+            self.echo(self.buf[:start])
+            del self.buf[:start]
+            if len(self.buf) < HEADER.size:
+                return
+
+            fields = HEADER.unpack_from(self.buf)
+            (_, kind, flags, frame, x, y, w, h, length, payload_sum,
+             header_sum) = fields
+            if (fletcher16(self.buf[:HEADER.size - 2]) != header_sum or
+                    length > MAX_PAYLOAD):
+                # Text that happens to contain "FB"
+                self.echo(self.buf[:1])
+                del self.buf[:1]
+                continue
+            if len(self.buf) < HEADER.size + length:
+                return
+
+            payload = bytes(self.buf[HEADER.size:HEADER.size + length])
+            del self.buf[:HEADER.size + length]
+            if fletcher16(payload) != payload_sum:
+                self.bad += 1
+                self.lost_sync()
+                continue
+            self.packet(kind, flags, frame, x, y, w, h, payload)
+
+    def lost_sync(self):
+        """Deltas can't be applied until the next key frame; ask for one."""
+        self.synced = False
+        if not self.request_key:
+            return
+        now = time.monotonic()
+        if (self.last_key_request is not None and
+                now - self.last_key_request < KEY_REQUEST_INTERVAL_S):
+            return
+        self.last_key_request = now
+        self.key_requests += 1
+        self.request_key()
+
+    def echo(self, data):
+        # Device log text between packets
+        self.log += data
+        while b"\n" in self.log:
+            line, _, rest = self.log.partition(b"\n")
+            sys.stderr.write("device: %s\n" %
+                             line.decode("utf-8", "replace").rstrip("\r"))
+            self.log = bytearray(rest)
+
+    def packet(self, kind, flags, frame, x, y, w, h, payload):
+        if kind == PACKET_AREA:
+            if flags & FLAG_KEY:
+                self.synced = True
+            if self.synced:
+                try:
+                    decode_area(payload, self.canvas, x, y, w, h)
+                except (ValueError, IndexError, struct.error) as e:
+                    print("frame %d: bad area (%s)" % (frame, e))
+                    self.lost_sync()
+            return
+        if kind != PACKET_FRAME_END:
+            return
+        if not self.synced:
+            self.lost_sync()  # Repeat the request if the key never came
+
+        areas, nbytes, raw, enc_us, push_us, dropped = STATS.unpack(payload)
+        self.frames += 1
+        for i, v in enumerate((nbytes, raw, enc_us, push_us)):
+            self.totals[i] += v
+        self.dropped = dropped
+
+        ratio = raw / nbytes if nbytes else 0
+        overhead = 100.0 * enc_us / push_us if push_us else 0
+        print("frame %5d%s: %2d areas, %7d B (raw %7d, %5.1fx), "
+              "encode %6d us / push %6d us (+%.1f%%), dropped %d" %
+              (frame, " key" if flags & FLAG_KEY else "", areas, nbytes, raw,
+               ratio, enc_us, push_us, overhead, dropped))
+
+        if self.outdir and self.synced:
+            write_png(os.path.join(self.outdir, "frame_%05d.png" % frame),
+                      self.canvas, self.swap)
+
+    def summary(self):
+        if not self.frames:
+            print("no frames")
+            return
+        nbytes, raw, enc_us, push_us = self.totals
+        print("%d frames: %.0f B/frame avg (raw %.0f), encode %.0f us/frame "
+              "(+%.1f%% of push time), %d dropped, %d corrupt packets, "
+              "%d key frames requested" %
+              (self.frames, nbytes / self.frames, raw / self.frames,
+               enc_us / self.frames, 100.0 * enc_us / push_us if push_us else 0,
+               self.dropped, self.bad, self.key_requests))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", help="USB CDC serial port of the device")
+    src.add_argument("--input", help="decode a stream recorded with --record")
+    ap.add_argument("-o", "--outdir", help="directory for PNG frames")
+    ap.add_argument("--record", help="also save the raw stream to this file")
+    ap.add_argument("--frames", type=int, default=0,
+                    help="stop after this many frames (default: until Ctrl-C)")
+    ap.add_argument("--swap-bytes", action="store_true",
+                    help="pixels are byte-swapped RGB565")
+    args = ap.parse_args()
+
+    if args.outdir:
+        os.makedirs(args.outdir, exist_ok=True)
+
+    if args.input:
+        dec = Decoder(args.outdir, args.swap_bytes)
+        with open(args.input, "rb") as f:
+            dec.feed(f.read())
+        dec.summary()
+        return
+
+    import serial  # pyserial
+
+    record = open(args.record, "wb") if args.record else None
+    port = serial.Serial(args.port, 115200, timeout=0.1)
+    dec = Decoder(args.outdir, args.swap_bytes,
+                  request_key=lambda: port.write(b"capture key\n"))
+    port.write(b"capture on\n")
+    try:
+        while not args.frames or dec.frames < args.frames:
+            data = port.read(65536)
+            if not data:
+                continue
+            if record:
+                record.write(data)
+            dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.write(b"capture off\n")
+        port.close()
+        if record:
+            record.close()
+    dec.summary()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,169 @@
+// Host build of the firmware update receiver for `ota_send.py --loopback`.
+// Speaks the same protocol as ota_update.cpp on stdin/stdout, decoding with
+// the firmware's ota_protocol.cpp and ota_lz.cpp, and writes the image to a
+// file instead of an OTA slot (the sender checks its SHA-256).
+//
+// Build from the repository root:
+//   c++ -std=c++17 -O2 -I src -o ota_loopback tools/ota_loopback.cpp
+//       src/ota_lz.cpp src/ota_protocol.cpp
+
+#include "ota_lz.h"
+#include "ota_protocol.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static lz_decoder_t dec;
+static ota_parser_t parser;
+static uint8_t *image = nullptr;
+static uint32_t image_size = 0;
+static uint32_t compressed_size = 0;
+static uint32_t received = 0;
+static uint32_t written = 0;
+static uint16_t next_seq = 0;
+
+static void reply(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  vprintf(fmt, ap);
+  va_end(ap);
+  fflush(stdout);
+}
+
+static int fail(const char *why) {
+  reply("OTA FAIL %s\n", why);
+  return 1;
+}
+
+// Unbuffered, so no frame bytes following the line are swallowed
+static bool read_line(char *line, size_t cap) {
+  size_t n = 0;
+  char c;
+  while (read(STDIN_FILENO, &c, 1) == 1) {
+    if (c == '\n') {
+      line[n] = '\0';
+      return true;
+    }
+    if (n + 1 < cap)
+      line[n++] = c;
+  }
+  return false;
+}
+
+// Decode a whole frame (the device spreads this over loop passes)
+static bool decode(const ota_frame_t *f) {
+  size_t pos = 0;
+  while (pos < f->len && !lz_decoder_done(&dec)) {
+    size_t used = 0;
+    written += lz_decode(&dec, f->payload + pos, f->len - pos, &used,
+                         image + written, image_size - written);
+    pos += used;
+    if (lz_decoder_error(&dec)) {
+      fail("corrupt stream");
+      return false;
+    }
+  }
+  if (pos < f->len) {
+    fail("data past end of image");
+    return false;
+  }
+  return true;
+}
+
+// Returns -1 to keep going, otherwise the exit code
+static int handle_frame(const ota_frame_t *f, const char *path) {
+  switch (f->type) {
+  case OTA_FRAME_DATA:
+    if (f->seq == next_seq) {
+      received += f->len;
+      if (!decode(f))
+        return 1;
+      reply("OTA ACK %u\n", next_seq++);
+    } else if (f->seq == (uint16_t)(next_seq - 1)) {
+      reply("OTA ACK %u\n", f->seq);
+    } else {
+      reply("OTA NAK %u\n", next_seq);
+    }
+    return -1;
+
+  case OTA_FRAME_END: {
+    if (f->seq != next_seq) {
+      reply("OTA NAK %u\n", next_seq);
+      return -1;
+    }
+    if (!lz_decoder_done(&dec))
+      return fail("image truncated");
+    if (received != compressed_size || written != image_size)
+      return fail("size mismatch");
+    FILE *out = fopen(path, "wb");
+    if (!out || fwrite(image, 1, image_size, out) != image_size) {
+      if (out)
+        fclose(out);
+      return fail("write failed");
+    }
+    fclose(out);
+    reply("OTA OK %lu -> %lu bytes\n", (unsigned long)received,
+          (unsigned long)image_size);
+    reply("OTA ACK %u\n", f->seq);
+    return 0;
+  }
+
+  case OTA_FRAME_ABORT:
+    return fail("aborted by sender");
+
+  default:
+    reply("OTA NAK %u\n", next_seq);
+    return -1;
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <image out>\n", argv[0]);
+    return 2;
+  }
+
+  // Console stage: wait for "ota begin <zsize> <size> <sha256>"
+  char line[160];
+  unsigned long zsize, size;
+  char sha_hex[72];
+  for (;;) {
+    if (!read_line(line, sizeof(line)))
+      return fail("stream ended");
+    if (sscanf(line, "ota begin %lu %lu %70s", &zsize, &size, sha_hex) == 3)
+      break;
+    reply("usage: ota begin <compressed size> <size> <sha256>\n");
+  }
+  image = (uint8_t *)malloc(size ? size : 1);
+  if (!image)
+    return fail("out of memory");
+  image_size = size;
+  compressed_size = zsize;
+  lz_decoder_init(&dec, size);
+  ota_parser_init(&parser);
+  reply("OTA READY host %lu\n", size);
+
+  // Binary stage: frames until END, ABORT or end of input
+  uint8_t buf[256];
+  for (;;) {
+    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+    if (n <= 0)
+      return fail("stream ended");
+    size_t pos = 0;
+    while (pos < (size_t)n) {
+      size_t used = 0;
+      ota_parse_result_t res =
+          ota_parser_feed(&parser, buf + pos, n - pos, &used);
+      pos += used;
+      if (res == OTA_PARSE_FRAME) {
+        int rc = handle_frame(&parser.frame, argv[1]);
+        if (rc >= 0)
+          return rc;
+      } else if (res == OTA_PARSE_BAD) {
+        reply("OTA NAK %u\n", next_seq);
+      }
+    }
+  }
+}
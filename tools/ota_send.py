@@ -0,0 +1,336 @@
+#!/usr/bin/env python3
+"""Compress a firmware image and send it to the device over USB CDC.
+
+The firmware decompresses the stream while writing it to the inactive OTA
+slot, checks the SHA-256 and reboots into the new image. The display and
+trackball keep working during the transfer.
+
+Example:
+  python tools/ota_send.py --port /dev/ttyACM0 \\
+      .pio/build/esp32-s3-devkitc-1/firmware.bin
+
+  # Write the framed stream to a file instead (no ACKs) for testing the
+  # decoder and framing on a host
+  python tools/ota_send.py --output stream.bin firmware.bin
+
+  # Full exchange with a host build of the receiver (tools/ota_loopback.cpp)
+  c++ -std=c++17 -O2 -I src -o ota_loopback tools/ota_loopback.cpp \\
+      src/ota_lz.cpp src/ota_protocol.cpp
+  python tools/ota_send.py --loopback ./ota_loopback firmware.bin
+
+Needs pyserial for --port. The compressed format must match src/ota_lz.h
+and the framing src/ota_protocol.h.
+"""
+
+import argparse
+import hashlib
+import os
+import select
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+WINDOW = 8192
+MIN_MATCH = 4
+MAX_CHAIN = 16  # Candidates tried per position (speed vs ratio)
+
+MAGIC = b"OU"
+FRAME_DATA = 1
+FRAME_END = 2
+FRAME_ABORT = 3
+MAX_PAYLOAD = 1024
+
+ACK_TIMEOUT_S = 2.0
+MAX_RETRIES = 5
+
+
+def put_length(out, n):
+    # Nibble of 15 continues in bytes of 255 plus a final byte < 255
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def compress(data):
+    """Greedy LZ77 with hash chains, byte-aligned sequences (see ota_lz.h)."""
+    out = bytearray()
+    heads = {}
+    chain = [0] * len(data)
+    n = len(data)
+    i = 0
+    lit_start = 0
+
+    def insert(pos):
+        if pos + MIN_MATCH <= n:
+            key = data[pos:pos + MIN_MATCH]
+            chain[pos] = heads.get(key, -1)
+            heads[key] = pos
+
+    def emit(lit_end, match_len, offset):
+        lits = data[lit_start:lit_end]
+        lit_nib = min(len(lits), 15)
+        m = match_len - MIN_MATCH if match_len else 0
+        match_nib = min(m, 15)
+        out.append((lit_nib << 4) | match_nib)
+        if lit_nib == 15:
+            put_length(out, len(lits) - 15)
+        out.extend(lits)
+        if match_len:
+            out.extend(struct.pack("<H", offset))
+            if match_nib == 15:
+                put_length(out, m - 15)
+
+    while i + MIN_MATCH <= n:
+        best_len = 0
+        best_off = 0
+        cand = heads.get(data[i:i + MIN_MATCH], -1)
+        tries = MAX_CHAIN
+        while cand >= 0 and i - cand <= WINDOW and tries:
+            length = MIN_MATCH
+            while i + length < n and data[cand + length] == data[i + length]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_off = i - cand
+            cand = chain[cand]
+            tries -= 1
+
+        if best_len >= MIN_MATCH:
+            emit(i, best_len, best_off)
+            for p in range(i, i + best_len):
+                insert(p)
+            i += best_len
+            lit_start = i
+        else:
+            insert(i)
+            i += 1
+
+    # Final sequence: literals only, the decoder stops at the image size
+    if lit_start < n or not out:
+        emit(n, 0, 0)
+    return bytes(out)
+
+
+def decompress(comp, size):
+    """Reference decoder, used to check the compressor before sending."""
+    out = bytearray()
+    i = 0
+    while len(out) < size:
+        token = comp[i]
+        i += 1
+        lits = token >> 4
+        if lits == 15:
+            while True:
+                b = comp[i]
+                i += 1
+                lits += b
+                if b != 255:
+                    break
+        out += comp[i:i + lits]
+        i += lits
+        if len(out) >= size:
+            break
+        (offset,) = struct.unpack_from("<H", comp, i)
+        i += 2
+        length = (token & 15) + MIN_MATCH
+        if token & 15 == 15:
+            while True:
+                b = comp[i]
+                i += 1
+                length += b
+                if b != 255:
+                    break
+        for _ in range(length):
+            out.append(out[-offset])
+    return bytes(out)
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def frame(kind, seq, payload=b""):
+    body = struct.pack("<BHH", kind, seq & 0xFFFF, len(payload)) + payload
+    return MAGIC + body + struct.pack("<H", crc16(body))
+
+
+def frames(comp):
+    seq = 0
+    for pos in range(0, len(comp), MAX_PAYLOAD):
+        yield seq, frame(FRAME_DATA, seq, comp[pos:pos + MAX_PAYLOAD])
+        seq += 1
+    yield seq, frame(FRAME_END, seq)
+
+
+class PipePort:
+    """Stands in for the serial port: talks to a host receiver over pipes."""
+
+    def __init__(self, argv):
+        self.proc = subprocess.Popen(argv, stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE)
+
+    def write(self, data):
+        try:
+            self.proc.stdin.write(data)
+            self.proc.stdin.flush()
+        except BrokenPipeError:
+            pass  # Receiver gave up; its last reply says why
+
+    def read(self, n):
+        fd = self.proc.stdout.fileno()
+        if not select.select([fd], [], [], 0.05)[0]:
+            return b""
+        data = os.read(fd, n)
+        if not data:
+            time.sleep(0.05)  # Receiver exited, behave like a quiet port
+        return data
+
+    def close(self):
+        try:
+            self.proc.stdin.close()
+        except BrokenPipeError:
+            pass
+        self.proc.wait(5)
+        self.proc.stdout.close()
+
+
+class Link:
+    """Line reader for device replies; other log lines are echoed."""
+
+    def __init__(self, port):
+        self.port = port
+        self.buf = b""
+
+    def line(self, timeout):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            if b"\n" in self.buf:
+                line, self.buf = self.buf.split(b"\n", 1)
+                text = line.decode("utf-8", "replace").strip()
+                if text.startswith("OTA"):
+                    return text
+                if text:
+                    print("device: %s" % text, file=sys.stderr)
+                continue
+            self.buf += self.port.read(256)
+        return None
+
+    def expect(self, prefix, timeout):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            text = self.line(deadline - time.time())
+            if text is None:
+                break
+            if text.startswith(prefix):
+                return text
+            if text.startswith("OTA FAIL"):
+                sys.exit(text)
+            if not text.startswith("OTA:"):
+                print("unexpected: %s" % text, file=sys.stderr)
+            else:
+                print(text)
+        return None
+
+
+def send(port, comp, size, digest):
+    link = Link(port)
+    port.write(b"ota begin %d %d %s\n" % (len(comp), size, digest.encode()))
+    if not link.expect("OTA READY", 5):
+        sys.exit("device did not answer 'ota begin'")
+
+    start = time.time()
+    sent = 0
+    for seq, data in frames(comp):
+        final = data[2] == FRAME_END
+        for _ in range(MAX_RETRIES):
+            port.write(data)
+            # The last ACK comes after the hash check, allow extra time
+            reply = link.expect("OTA ", 30 if final else ACK_TIMEOUT_S)
+            if reply == "OTA ACK %d" % seq or (final and reply and
+                                               reply.startswith("OTA OK")):
+                if final and reply.startswith("OTA OK"):
+                    print(reply)
+                break
+            if reply and reply.startswith("OTA ACK"):
+                continue  # Stale ACK for an earlier frame
+        else:
+            port.write(frame(FRAME_ABORT, seq))
+            sys.exit("frame %d not acknowledged" % seq)
+        sent += len(data)
+        if seq % 64 == 0 and not final:
+            rate = sent / max(time.time() - start, 1e-3) / 1024
+            print("\r%d/%d bytes (%.0f KB/s)" % (sent, len(comp), rate),
+                  end="", flush=True)
+
+    print("\nsent %d bytes in %.1f s" % (sent, time.time() - start))
+
+
+def loopback(receiver, comp, image, digest):
+    """Send to a host receiver and check the image it rebuilt."""
+    fd, path = tempfile.mkstemp(suffix=".bin")
+    os.close(fd)
+    port = PipePort([receiver, path])
+    try:
+        send(port, comp, len(image), digest)
+        with open(path, "rb") as f:
+            rebuilt = f.read()
+    finally:
+        port.close()
+        os.remove(path)
+    if hashlib.sha256(rebuilt).hexdigest() != digest:
+        sys.exit("loopback: sha256 mismatch")
+    print("loopback: image rebuilt, sha256 ok")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", help="firmware .bin")
+    dest = ap.add_mutually_exclusive_group(required=True)
+    dest.add_argument("--port", help="USB CDC serial port of the device")
+    dest.add_argument("--output", help="write the framed stream to a file")
+    dest.add_argument("--loopback", metavar="RECEIVER",
+                      help="send to a host receiver build instead of a device")
+    args = ap.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    digest = hashlib.sha256(image).hexdigest()
+
+    t0 = time.time()
+    comp = compress(image)
+    if decompress(comp, len(image)) != image:
+        sys.exit("compressor self-check failed")
+    print("%s: %d -> %d bytes (%.1f%%) in %.1f s, sha256 %s" %
+          (args.image, len(image), len(comp), 100.0 * len(comp) / len(image),
+           time.time() - t0, digest))
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(b"ota begin %d %d %s\n" % (len(comp), len(image),
+                                               digest.encode()))
+            for _, data in frames(comp):
+                f.write(data)
+        return
+
+    if args.loopback:
+        loopback(args.loopback, comp, image, digest)
+        return
+
+    import serial  # pyserial
+
+    port = serial.Serial(args.port, 115200, timeout=0.05)
+    send(port, comp, len(image), digest)
+    port.close()
+
+
+if __name__ == "__main__":
+    main()
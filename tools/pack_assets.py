@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""Build an asset pack for the `assets` data partition.
+
+Assets are given as TYPE:NAME=PATH. Ids are assigned in command-line order
+and written to a C header so firmware can look assets up in O(1):
+
+  font   LVGL binary font from lv_font_conv --format bin --no-compress
+         (converted to a flat layout the firmware uses in place)
+  image  LVGL 9 image binary from LVGLImage.py --ofmt BIN
+  raw    any file, stored as-is
+
+Example:
+  lv_font_conv --font Montserrat-Medium.ttf -r 0x20-0x7F --size 32 --bpp 4 \
+      --format bin --no-compress -o montserrat_32.bin
+  python tools/pack_assets.py -o assets.bin --header src/asset_ids.h \
+      font:MONTSERRAT_32=montserrat_32.bin image:LOGO=logo.bin
+  esptool.py --chip esp32s3 write_flash 0x610000 assets.bin
+
+Use --list to parse an existing pack and print its index.
+The layout must match src/asset_pack_index.h.
+"""
+
+import argparse
+import struct
+import sys
+
+PACK_MAGIC = 0x4B415041  # "APAK"
+PACK_VERSION = 1
+FONT_MAGIC = 0x544E4646  # "FFNT"
+
+TYPE_RAW = 0
+TYPE_FONT = 1
+TYPE_IMAGE = 2
+TYPES = {"raw": TYPE_RAW, "font": TYPE_FONT, "image": TYPE_IMAGE}
+
+PACK_HEADER = struct.Struct("<IHHII")
+INDEX_ENTRY = struct.Struct("<IIHHI")
+FONT_HEADER = struct.Struct("<IhhhHBBHIIIII")
+FONT_CMAP = struct.Struct("<IHHHBBII")
+
+LV_IMAGE_HEADER_MAGIC = 0x19
+
+
+def align4(n):
+    return (n + 3) & ~3
+
+
+def pad4(data):
+    return data + b"\0" * (align4(len(data)) - len(data))
+
+
+def name_hash(name):
+    h = 2166136261
+    for b in name.encode():
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+class BitReader:
+    """MSB-first bit reader matching LVGL's binfont loader."""
+
+    def __init__(self, data, offset):
+        self.data = data
+        self.pos = offset * 8
+
+    def bits(self, n):
+        v = 0
+        for _ in range(n):
+            byte = self.pos // 8
+            bit = 0
+            if byte < len(self.data):
+                bit = (self.data[byte] >> (7 - self.pos % 8)) & 1
+            v = (v << 1) | bit
+            self.pos += 1
+        return v
+
+    def signed(self, n):
+        v = self.bits(n)
+        if n and v & (1 << (n - 1)):
+            v -= 1 << n
+        return v
+
+
+def read_tables(data):
+    tables = {}
+    pos = 0
+    while pos + 8 <= len(data):
+        length, tag = struct.unpack_from("<I4s", data, pos)
+        if length < 8:
+            raise ValueError("corrupt binfont table at %d" % pos)
+        tables[tag.decode("ascii")] = (pos, length)
+        pos += length
+    return tables
+
+
+def convert_font(data):
+    """Convert an lv_font_conv binary font into the flat pack layout."""
+    tables = read_tables(data)
+    for tag in ("head", "cmap", "loca", "glyf"):
+        if tag not in tables:
+            raise ValueError("binfont is missing the '%s' table" % tag)
+
+    pos, _ = tables["head"]
+    (_version, _tables, _size, ascent, descent, _typo_asc, _typo_desc,
+     _typo_gap, _min_y, _max_y, default_adv, _kern_scale, loca_fmt,
+     _glyph_id_fmt, adv_fmt, bpp, xy_bits, wh_bits, adv_bits, compression,
+     subpx, _pad, ul_pos, ul_thick) = struct.unpack_from(
+        "<IHHHhHhHhhHHBBBBBBBBBBhH", data, pos + 8)
+    if compression != 0:
+        raise ValueError("compressed binfonts are not supported, use --no-compress")
+    if bpp not in (1, 2, 4, 8):
+        raise ValueError("unsupported bpp %d" % bpp)
+    if "kern" in tables:
+        print("  note: kerning table ignored", file=sys.stderr)
+
+    # Glyph locations
+    pos, _ = tables["loca"]
+    (loca_count,) = struct.unpack_from("<I", data, pos + 8)
+    fmt = "<%d%s" % (loca_count, "H" if loca_fmt == 0 else "I")
+    loca = struct.unpack_from(fmt, data, pos + 12)
+
+    glyf_pos, _ = tables["glyf"]
+    glyph_dsc = bytearray()
+    bitmap = bytearray()
+    for i, ofs in enumerate(loca):
+        rd = BitReader(data, glyf_pos + ofs)
+        adv = rd.bits(adv_bits) if adv_bits else default_adv
+        if adv_fmt == 0:
+            adv *= 16
+        ofs_x = rd.signed(xy_bits)
+        ofs_y = rd.signed(xy_bits)
+        box_w = rd.bits(wh_bits)
+        box_h = rd.bits(wh_bits)
+        if i == 0:  # Reserved glyph
+            adv = ofs_x = ofs_y = box_w = box_h = 0
+
+        bmp_index = len(bitmap)
+        if box_w and box_h:
+            # Bitmaps are re-packed to start on a byte boundary
+            nbits = box_w * box_h * bpp
+            bitmap += bytes(rd.bits(8) for _ in range(nbits // 8))
+            if nbits % 8:
+                rem = nbits % 8
+                bitmap.append(rd.bits(rem) << (8 - rem))
+
+        if bmp_index >= 1 << 20 or adv >= 1 << 12:
+            raise ValueError("glyph %d does not fit lv_font_fmt_txt_glyph_dsc_t" % i)
+        glyph_dsc += struct.pack("<IBBbb", bmp_index | (adv << 20), box_w,
+                                 box_h, ofs_x, ofs_y)
+
+    # Character maps: same semantics as lv_font_fmt_txt_cmap_t
+    cmap_pos, _ = tables["cmap"]
+    (sub_count,) = struct.unpack_from("<I", data, cmap_pos + 8)
+    cmaps = []
+    for i in range(sub_count):
+        (data_ofs, range_start, range_len, glyph_start, entries, ctype,
+         _p) = struct.unpack_from("<IIHHHBB", data, cmap_pos + 12 + i * 16)
+        src = cmap_pos + data_ofs
+        unicode_list = b""
+        id_ofs = b""
+        if ctype == 0:  # FORMAT0_FULL: uint8_t offsets
+            id_ofs = data[src:src + entries]
+        elif ctype == 1:  # SPARSE_FULL: uint16 list + uint16 offsets
+            unicode_list = data[src:src + entries * 2]
+            id_ofs = data[src + entries * 2:src + entries * 4]
+        elif ctype == 3:  # SPARSE_TINY: uint16 list
+            unicode_list = data[src:src + entries * 2]
+        elif ctype != 2:
+            raise ValueError("unknown cmap type %d" % ctype)
+        cmaps.append((range_start, range_len, glyph_start, entries, ctype,
+                      unicode_list, id_ofs))
+
+    # Lay out: header, cmap records, cmap arrays, glyph dsc, bitmap
+    out = bytearray(FONT_HEADER.size)
+    cmaps_offset = len(out)
+    out += b"\0" * (FONT_CMAP.size * len(cmaps))
+    records = []
+    for (start, length, gstart, entries, ctype, ulist, id_ofs) in cmaps:
+        ulist_ofs = 0
+        id_ofs_ofs = 0
+        if ulist:
+            out = bytearray(pad4(bytes(out)))
+            ulist_ofs = len(out)
+            out += ulist
+        if id_ofs:
+            out = bytearray(pad4(bytes(out)))
+            id_ofs_ofs = len(out)
+            out += id_ofs
+        records.append(FONT_CMAP.pack(start, length, gstart, entries, ctype, 0,
+                                      ulist_ofs, id_ofs_ofs))
+    out[cmaps_offset:cmaps_offset + FONT_CMAP.size * len(records)] = b"".join(records)
+
+    out = bytearray(pad4(bytes(out)))
+    glyph_dsc_offset = len(out)
+    out += glyph_dsc
+    bitmap_offset = len(out)
+    out += bitmap
+
+    line_height = ascent - descent
+    base_line = -descent
+    out[0:FONT_HEADER.size] = FONT_HEADER.pack(
+        FONT_MAGIC, line_height, base_line, ul_pos, ul_thick, bpp, subpx,
+        len(cmaps), len(loca), cmaps_offset, glyph_dsc_offset, bitmap_offset,
+        len(bitmap))
+    return bytes(out)
+
+
+def check_image(data):
+    if len(data) < 12 or data[0] != LV_IMAGE_HEADER_MAGIC:
+        raise ValueError("not an LVGL 9 image binary (bad header magic)")
+    return data
+
+
+def build_pack(assets):
+    index_offset = PACK_HEADER.size
+    data_offset = align4(index_offset + INDEX_ENTRY.size * len(assets))
+    entries = []
+    blob = bytearray()
+    for name, atype, payload in assets:
+        offset = data_offset + len(blob)
+        entries.append(INDEX_ENTRY.pack(offset, len(payload), atype, 0,
+                                        name_hash(name)))
+        blob += pad4(payload)
+
+    total = data_offset + len(blob)
+    out = bytearray(PACK_HEADER.pack(PACK_MAGIC, PACK_VERSION, len(assets),
+                                     index_offset, total))
+    out += b"".join(entries)
+    out += b"\0" * (data_offset - len(out))
+    out += blob
+    return bytes(out)
+
+
+def write_header(path, assets):
+    lines = [
+        "#pragma once",
+        "",
+        "// Generated by tools/pack_assets.py - do not edit",
+        "",
+    ]
+    for i, (name, atype, _) in enumerate(assets):
+        kind = [k for k, v in TYPES.items() if v == atype][0].upper()
+        lines.append("#define ASSET_%s_%s %d" % (kind, name.upper(), i))
+    lines.append("#define ASSET_COUNT %d" % len(assets))
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+def list_pack(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, count, index_offset, total = PACK_HEADER.unpack_from(data, 0)
+    if magic != PACK_MAGIC or version != PACK_VERSION:
+        raise ValueError("not an asset pack (v%d)" % PACK_VERSION)
+    print("%d assets, %d bytes" % (count, total))
+    names = {v: k for k, v in TYPES.items()}
+    for i in range(count):
+        offset, size, atype, _flags, h = INDEX_ENTRY.unpack_from(
+            data, index_offset + i * INDEX_ENTRY.size)
+        print("  %3d  %-5s  offset 0x%08x  %8d bytes  hash 0x%08x" %
+              (i, names.get(atype, "?"), offset, size, h))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("assets", nargs="*", help="TYPE:NAME=PATH")
+    ap.add_argument("-o", "--output", help="pack file to write")
+    ap.add_argument("--header", help="C header with asset id defines")
+    ap.add_argument("--list", metavar="PACK", help="print the index of a pack")
+    args = ap.parse_args()
+
+    if args.list:
+        list_pack(args.list)
+        return
+    if not args.output or not args.assets:
+        ap.error("need -o and at least one asset")
+
+    assets = []
+    for spec in args.assets:
+        try:
+            kind, rest = spec.split(":", 1)
+            name, path = rest.split("=", 1)
+            atype = TYPES[kind]
+        except (ValueError, KeyError):
+            ap.error("bad asset spec '%s' (expected TYPE:NAME=PATH)" % spec)
+        with open(path, "rb") as f:
+            data = f.read()
+        print("%-5s %-20s %s" % (kind, name, path))
+        if atype == TYPE_FONT:
+            data = convert_font(data)
+        elif atype == TYPE_IMAGE:
+            data = check_image(data)
+        assets.append((name, atype, data))
+
+    pack = build_pack(assets)
+    with open(args.output, "wb") as f:
+        f.write(pack)
+    print("Wrote %s: %d assets, %d bytes" % (args.output, len(assets), len(pack)))
+    if args.header:
+        write_header(args.header, assets)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Round-trip images through ota_send.py and the firmware's decoder and
+framing (src/ota_lz.cpp, src/ota_protocol.cpp) in a host receiver build
+(tools/ota_loopback.cpp), including corrupted and truncated streams.
+
+  python -m unittest discover tools
+
+Needs a host C++ compiler (c++ on PATH); skipped without one.
+"""
+
+import os
+import random
+import shutil
+import subprocess
+import tempfile
+import unittest
+
+import ota_send
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SRC = os.path.join(ROOT, "src")
+
+
+def make_image(size, seed):
+    """Firmware-like data: repeated code-ish runs mixed with noise."""
+    rnd = random.Random(seed)
+    words = [bytes(rnd.randrange(256) for _ in range(rnd.randrange(4, 40)))
+             for _ in range(64)]
+    out = bytearray()
+    while len(out) < size:
+        if rnd.random() < 0.2:
+            out += bytes(rnd.randrange(256) for _ in range(16))
+        else:
+            out += rnd.choice(words)
+    return bytes(out[:size])
+
+
+class FaultyPort(ota_send.PipePort):
+    """PipePort that corrupts chosen writes the first time they are sent."""
+
+    def __init__(self, argv, corrupt=()):
+        super().__init__(argv)
+        self.corrupt = set(corrupt)
+        self.writes = 0
+
+    def write(self, data):
+        if self.writes in self.corrupt:
+            data = bytearray(data)
+            data[len(data) // 2] ^= 0x5A
+            data = bytes(data)
+        self.writes += 1
+        super().write(data)
+
+
+@unittest.skipUnless(shutil.which("c++"), "needs a host C++ compiler")
+class OtaLoopbackTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.tmp = tempfile.mkdtemp()
+        cls.receiver = os.path.join(cls.tmp, "ota_loopback")
+        subprocess.check_call([
+            "c++", "-std=c++17", "-O2", "-Wall", "-I", SRC, "-o", cls.receiver,
+            os.path.join(ROOT, "tools", "ota_loopback.cpp"),
+            os.path.join(SRC, "ota_lz.cpp"), os.path.join(SRC, "ota_protocol.cpp")])
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.tmp)
+
+    def setUp(self):
+        self.out = os.path.join(self.tmp, "rebuilt.bin")
+        if os.path.exists(self.out):
+            os.remove(self.out)
+
+    def prepare(self, image):
+        comp = ota_send.compress(image)
+        self.assertEqual(ota_send.decompress(comp, len(image)), image)
+        return comp, ota_send.hashlib.sha256(image).hexdigest()
+
+    def rebuilt(self):
+        with open(self.out, "rb") as f:
+            return f.read()
+
+    def raw_exchange(self, stream):
+        """Push bytes at the receiver without waiting for replies."""
+        proc = subprocess.run([self.receiver, self.out], input=stream,
+                              stdout=subprocess.PIPE, timeout=10)
+        return proc.returncode, proc.stdout.decode().splitlines()
+
+    def test_round_trip(self):
+        for size, seed in ((1, 1), (4000, 2), (150000, 3)):
+            image = make_image(size, seed)
+            comp, digest = self.prepare(image)
+            port = ota_send.PipePort([self.receiver, self.out])
+            ota_send.send(port, comp, len(image), digest)
+            port.close()
+            self.assertEqual(port.proc.returncode, 0)
+            self.assertEqual(self.rebuilt(), image)
+
+    def test_loopback_mode(self):
+        image = make_image(50000, 8)
+        comp, digest = self.prepare(image)
+        ota_send.loopback(self.receiver, comp, image, digest)
+
+    def test_corrupted_chunk_is_resent(self):
+        image = make_image(20000, 4)
+        comp, digest = self.prepare(image)
+        nframes = len(list(ota_send.frames(comp)))
+        self.assertGreater(nframes, 3)
+
+        # Write 0 is "ota begin"; damage the first copy of frame 1 (write 2)
+        # and of frame 3 (write 5, after frame 1's resend)
+        port = FaultyPort([self.receiver, self.out], corrupt=(2, 5))
+        ota_send.send(port, comp, len(image), digest)
+        port.close()
+        self.assertEqual(self.rebuilt(), image)
+        self.assertEqual(port.writes, 1 + nframes + 2)
+
+    def test_corrupted_payload_with_valid_crc_fails(self):
+        # Damage inside the compressed data passes framing; the decoder or
+        # the final hash check has to catch it
+        image = make_image(20000, 5)
+        comp, digest = self.prepare(image)
+        bad = bytearray(comp)
+        for i in range(100, len(bad), 997):
+            bad[i] ^= 0xFF
+        with self.assertRaises(SystemExit):
+            ota_send.loopback(self.receiver, bytes(bad), image, digest)
+
+    def test_truncated_stream(self):
+        image = make_image(20000, 6)
+        comp, digest = self.prepare(image)
+        begin = b"ota begin %d %d %s\n" % (len(comp), len(image), digest.encode())
+        frames = [data for _, data in ota_send.frames(comp)]
+
+        # Stream stops part-way through a frame
+        stream = begin + b"".join(frames[:2]) + frames[2][:100]
+        rc, lines = self.raw_exchange(stream)
+        self.assertNotEqual(rc, 0)
+        self.assertEqual(lines[-1], "OTA FAIL stream ended")
+        self.assertFalse(os.path.exists(self.out))
+
+        # END arrives with half the data sent
+        half = len(frames) // 2
+        stream = (begin + b"".join(frames[:half - 1]) +
+                  ota_send.frame(ota_send.FRAME_END, half - 1))
+        rc, lines = self.raw_exchange(stream)
+        self.assertNotEqual(rc, 0)
+        self.assertEqual(lines[-1], "OTA FAIL image truncated")
+        self.assertIn("OTA ACK %d" % (half - 2), lines)
+        self.assertFalse(os.path.exists(self.out))
+
+    def test_short_compressed_stream(self):
+        # Claims a longer image than the data expands to
+        image = make_image(20000, 7)
+        comp, digest = self.prepare(image)
+        begin = b"ota begin %d %d %s\n" % (len(comp), len(image) + 1000,
+                                           digest.encode())
+        stream = begin + b"".join(data for _, data in ota_send.frames(comp))
+        rc, lines = self.raw_exchange(stream)
+        self.assertNotEqual(rc, 0)
+        self.assertTrue(lines[-1].startswith("OTA FAIL"))
+
+
+if __name__ == "__main__":
+    unittest.main()
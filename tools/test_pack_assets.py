@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Pack a synthetic font with pack_assets.py and validate it with the
+firmware's loader (src/asset_pack_index.cpp built for the host).
+
+  python -m unittest discover tools
+
+Needs a host C++ compiler (c++ on PATH); skipped without one.
+"""
+
+import ctypes
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+import unittest
+
+import pack_assets
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SRC = os.path.join(ROOT, "src")
+
+SHIM = r"""
+#include "asset_pack_index.h"
+#include <string.h>
+
+extern "C" int font_glyphs(const void *base, size_t size, uint16_t id) {
+  asset_pack_t pack;
+  if (!asset_pack_parse(base, size, &pack))
+    return -1;
+  const asset_font_header_t *hdr = asset_pack_font_header(&pack, id);
+  return hdr ? (int)hdr->glyph_count : -2;
+}
+
+extern "C" int get_asset(const void *base, size_t size, uint16_t id,
+                         uint16_t type, uint8_t *out, uint32_t cap) {
+  asset_pack_t pack;
+  uint32_t len = 0;
+  if (!asset_pack_parse(base, size, &pack))
+    return -1;
+  const void *data = asset_pack_get(&pack, id, type, &len);
+  if (!data || len > cap)
+    return -2;
+  memcpy(out, data, len);
+  return (int)len;
+}
+"""
+
+BPP = 4
+# (adv, ofs_x, ofs_y, box_w, box_h) for 'A' and 'B'; glyph 0 is reserved
+GLYPHS = [(8, 0, 0, 0, 0), (9, 1, 0, 5, 7), (9, 1, 0, 3, 6)]
+
+
+class BitWriter:
+    """MSB-first, the counterpart of pack_assets.BitReader."""
+
+    def __init__(self):
+        self.bits = []
+
+    def put(self, value, n):
+        for i in reversed(range(n)):
+            self.bits.append((value >> i) & 1)
+
+    def data(self):
+        bits = self.bits + [0] * (-len(self.bits) % 8)
+        return bytes(int("".join(map(str, bits[i:i + 8])), 2)
+                     for i in range(0, len(bits), 8))
+
+
+def table(tag, body):
+    return struct.pack("<I4s", 8 + len(body), tag.encode()) + body
+
+
+def make_binfont():
+    """Minimal uncompressed lv_font_conv binary font: 'A' and 'B'."""
+    xy_bits, wh_bits, adv_bits = 4, 4, 8
+    head = table("head", struct.pack(
+        "<IHHHhHhHhhHHBBBBBBBBBBhH", 1, 4, 14, 12, -2, 12, -2, 0, -2, 12,
+        8, 0, 0, 0, 1, BPP, xy_bits, wh_bits, adv_bits, 0, 0, 0, -1, 1))
+
+    glyf = b""
+    loca = []
+    for adv, ofs_x, ofs_y, box_w, box_h in GLYPHS:
+        w = BitWriter()
+        w.put(adv, adv_bits)
+        w.put(ofs_x & 0xF, xy_bits)
+        w.put(ofs_y & 0xF, xy_bits)
+        w.put(box_w, wh_bits)
+        w.put(box_h, wh_bits)
+        for px in range(box_w * box_h):
+            w.put(px % 16, BPP)
+        loca.append(8 + len(glyf))
+        glyf += w.data()
+    glyf = table("glyf", glyf)
+    loca = table("loca", struct.pack("<I%dH" % len(loca), len(loca), *loca))
+
+    # One FORMAT0_TINY range: 'A'..'B' -> glyphs 1..2
+    cmap = table("cmap", struct.pack("<I", 1) +
+                 struct.pack("<IIHHHBB", 0, 0x41, 2, 1, 0, 2, 0))
+    return head + cmap + loca + glyf
+
+
+def glyph_bytes(box_w, box_h):
+    return (box_w * box_h * BPP + 7) // 8
+
+
+@unittest.skipUnless(shutil.which("c++"), "needs a host C++ compiler")
+class PackAssetsTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.tmp = tempfile.mkdtemp()
+        shim = os.path.join(cls.tmp, "shim.cpp")
+        lib = os.path.join(cls.tmp, "libasset_pack.so")
+        with open(shim, "w") as f:
+            f.write(SHIM)
+        subprocess.check_call(["c++", "-std=c++17", "-Wall", "-shared", "-fPIC",
+                               "-I", SRC, "-o", lib, shim,
+                               os.path.join(SRC, "asset_pack_index.cpp")])
+        cls.lib = ctypes.CDLL(lib)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.tmp)
+
+    def setUp(self):
+        self.font = pack_assets.convert_font(make_binfont())
+        self.pack = bytearray(pack_assets.build_pack([
+            ("font", pack_assets.TYPE_FONT, self.font),
+            ("blob", pack_assets.TYPE_RAW, b"hello"),
+        ]))
+
+    def font_glyphs(self, pack):
+        buf = ctypes.create_string_buffer(bytes(pack), len(pack))
+        return self.lib.font_glyphs(buf, ctypes.c_size_t(len(pack)), 0)
+
+    def font_start(self):
+        entry = pack_assets.INDEX_ENTRY.unpack_from(
+            self.pack, pack_assets.PACK_HEADER.size)
+        return entry[0]
+
+    def test_font_round_trip(self):
+        self.assertEqual(self.font_glyphs(self.pack), len(GLYPHS))
+        header = pack_assets.FONT_HEADER.unpack_from(self.font, 0)
+        self.assertEqual(header[5], BPP)
+        self.assertEqual(header[12], sum(glyph_bytes(g[3], g[4])
+                                         for g in GLYPHS))
+
+    def test_raw_asset(self):
+        buf = ctypes.create_string_buffer(bytes(self.pack), len(self.pack))
+        out = ctypes.create_string_buffer(16)
+        n = self.lib.get_asset(buf, ctypes.c_size_t(len(self.pack)), 1,
+                               pack_assets.TYPE_RAW, out, 16)
+        self.assertEqual(out.raw[:n], b"hello")
+        # Wrong type or id out of range
+        self.assertEqual(self.lib.get_asset(buf, ctypes.c_size_t(len(self.pack)),
+                                            1, pack_assets.TYPE_FONT, out, 16), -2)
+        self.assertEqual(self.lib.get_asset(buf, ctypes.c_size_t(len(self.pack)),
+                                            2, pack_assets.TYPE_RAW, out, 16), -2)
+
+    def test_truncated_pack(self):
+        self.assertEqual(self.font_glyphs(self.pack[:-8]), -1)
+
+    def test_glyph_count_overflow(self):
+        # glyph_count (header offset 16): 0x20000001 * 8 wraps to 8 in 32 bits
+        struct.pack_into("<I", self.pack, self.font_start() + 16, 0x20000001)
+        self.assertEqual(self.font_glyphs(self.pack), -2)
+
+    def test_glyph_bitmap_out_of_range(self):
+        header = pack_assets.FONT_HEADER.unpack_from(self.font, 0)
+        glyph_dsc = self.font_start() + header[10]
+        # Last glyph's bitmap starts one byte too late
+        last = glyph_dsc + 8 * (len(GLYPHS) - 1)
+        (word,) = struct.unpack_from("<I", self.pack, last)
+        struct.pack_into("<I", self.pack, last, word + 1)
+        self.assertEqual(self.font_glyphs(self.pack), -2)
+
+
+if __name__ == "__main__":
+    unittest.main()